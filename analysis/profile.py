@@ -1,4 +1,5 @@
 from collections import defaultdict
+import os
 import pandas as pd
 import matplotlib as mpl
 import matplotlib.pyplot as plt
@@ -19,6 +20,14 @@ for config in ['vanilla', 'bloom']:
 
     data = {}
     for query in queries:
+        # The CSVs of ssb_sqlite3_vdbe_profile --profile, or vdbe_profile.out
+        # split by hand.
+        path = f'data/ssb/profiles/{config}/{query.lower()}.csv'
+        if os.path.exists(path):
+            df = pd.read_csv(path)
+            data[query] = df.groupby('opcode')['cycles'].sum().to_dict()
+            continue
+
         profile = defaultdict(int)
         with open(f'data/ssb/profiles/{config}/{query}.txt', 'r') as f:
             for line in f:
@@ -5,11 +5,21 @@
   ./ssb.sh
 )
 
+(
+  cd tpch || exit
+  ./tpch.sh
+)
+
 (
   cd tatp || exit
   ./tatp.sh
 )
 
+(
+  cd htap || exit
+  ./htap.sh
+)
+
 (
   cd blob || exit
   ./blob.sh
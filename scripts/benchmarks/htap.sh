@@ -0,0 +1,43 @@
+#!/bin/bash
+
+# The SSB data comes from the dbgen built next to ssb_sqlite3.
+for sf in 1 2 5; do
+  printf "*** HTAP (SSB scale factor %s, TATP scale factor 100000) ***\n" "$sf"
+
+  printf "Generating data...\n"
+  (
+    cd ../ssb || exit
+    rm -f ./*.tbl
+    ./dbgen -s "$sf"
+  )
+  ln -sf ../ssb/*.tbl .
+
+  printf "Loading data into SQLite3...\n"
+  ../sqlite3_shell htap.sqlite <sql/init/sqlite3.sql
+  ./htap_sqlite3 --load --records=100000
+
+  printf "Evaluating SQLite3...\n"
+  for clients in 1 2 4; do
+    for readers in 1 2 4; do
+      command="./htap_sqlite3 --run --records=100000 --clients=$clients --readers=$readers"
+      printf "%s\n" "$command"
+      eval "$command"
+    done
+  done
+
+  rm htap.sqlite*
+
+  printf "Loading data into DuckDB...\n"
+  ./htap_duckdb --load --records=100000
+
+  printf "Evaluating DuckDB...\n"
+  for clients in 1 2 4; do
+    for readers in 1 2 4; do
+      command="./htap_duckdb --run --records=100000 --clients=$clients --readers=$readers"
+      printf "%s\n" "$command"
+      eval "$command"
+    done
+  done
+
+  rm htap.duckdb ./*.tbl
+done
@@ -4,16 +4,72 @@ for sf in 1 2 5; do
   printf "*** SSB (scale factor %s) ***\n" "$sf"
 
   printf "Generating data...\n"
-  rm -f ./*.tbl
+  rm -f ./*.tbl ./*.col
   ./dbgen -s "$sf"
+  # The same tables as binary column files, which the loaders bind without
+  # parsing.
+  ./dbgen -s "$sf" -f -D
 
   printf "Loading data into SQLite3...\n"
-  ../sqlite3_shell ssb.sqlite <sql/init/sqlite3.sql
+  printf "part,supplier,customer,date,lineorder,foreign_keys\n"
+  ./ssb_sqlite3 --load --threads=4
 
+  printf "Loading binary column files into SQLite3...\n"
+  printf "part,supplier,customer,date,lineorder,foreign_keys\n"
+  ./ssb_sqlite3 --load --load_format=col
+
+  # The same data, generated straight into the database without .tbl files.
+  printf "Generating data into SQLite3...\n"
+  time ./dbgen_sqlite3 -s "$sf" -f -D -n ssb.sqlite
+
+  # The feature matrix runs at the default cache size of 1 GB. Only the
+  # baseline and the best configurations sweep the cache size below.
   printf "Evaluating SQLite3...\n"
-  for bloom_filter in "false" "true"; do
+  configs=()
+  for vectorized in "false" "true"; do
+    for hash_join in "false" "true"; do
+      for hash_aggregate in "false" "true"; do
+        for bloom_filter in "false" "true"; do
+          configs+=("--vectorized=$vectorized --hash_join=$hash_join --hash_aggregate=$hash_aggregate --bloom_filter=$bloom_filter")
+        done
+      done
+    done
+  done
+  # The layout and prefetching only apply to the filters that hash joins
+  # build for the vectorized scan.
+  for hash_aggregate in "false" "true"; do
+    configs+=("--vectorized=true --hash_join=true --hash_aggregate=$hash_aggregate --bloom_filter=true --bloom_filter_layout=blocked")
+    configs+=("--vectorized=true --hash_join=true --hash_aggregate=$hash_aggregate --bloom_filter=true --prefetch=true")
+  done
+  for hash_join in "false" "true"; do
+    for hash_aggregate in "false" "true"; do
+      configs+=("--columnar=true --hash_join=$hash_join --hash_aggregate=$hash_aggregate")
+    done
+  done
+  # No --zone_maps: the queries only restrict lo_orderdate through the join
+  # with date, so the zone map skips no zone of lineorder, even of one loaded
+  # clustered on lo_orderdate with --load --zone_maps.
+
+  for config in "${configs[@]}"; do
+    command="./ssb_sqlite3 $config"
+    printf "%s\n" "$command"
+    printf "trial,Q1.1,Q1.2,Q1.3,Q2.1,Q2.2,Q2.3,Q3.1,Q3.2,Q3.3,Q3.4,Q4.1,Q4.2,Q4.3\n"
+    for trial in {1..3}; do
+      printf "%s," "$trial"
+      eval "$command"
+    done
+  done
+
+  # SQLite as it is, with and without its Bloom filters, against the fastest
+  # configurations of the matrix.
+  printf "Evaluating SQLite3 (cache size)...\n"
+  configs=("--bloom_filter=false" "--bloom_filter=true")
+  configs+=("--vectorized=true --hash_join=true --hash_aggregate=true --bloom_filter=true")
+  configs+=("--vectorized=true --hash_join=true --hash_aggregate=true --bloom_filter=true --prefetch=true")
+  configs+=("--columnar=true --hash_join=true --hash_aggregate=true")
+  for config in "${configs[@]}"; do
     for cache_size in "-100000" "-200000" "-500000" "-1000000" "-2000000" "-5000000"; do
-      command="./ssb_sqlite3 --bloom_filter=$bloom_filter --cache_size=$cache_size"
+      command="./ssb_sqlite3 $config --cache_size=$cache_size"
       printf "%s\n" "$command"
       printf "trial,Q1.1,Q1.2,Q1.3,Q2.1,Q2.2,Q2.3,Q3.1,Q3.2,Q3.3,Q3.4,Q4.1,Q4.2,Q4.3\n"
       for trial in {1..3}; do
@@ -23,10 +79,67 @@ for sf in 1 2 5; do
     done
   done
 
-  rm ssb.sqlite
+  printf "Evaluating SQLite3 (multi-threaded)...\n"
+  for threads in 1 2 4; do
+    for bloom_filter in "false" "true"; do
+      command="./ssb_sqlite3_mt --threads=$threads --bloom_filter=$bloom_filter"
+      printf "%s\n" "$command"
+      printf "trial,Q1.1,Q1.2,Q1.3,Q2.1,Q2.2,Q2.3,Q3.1,Q3.2,Q3.3,Q3.4,Q4.1,Q4.2,Q4.3\n"
+      for trial in {1..3}; do
+        printf "%s," "$trial"
+        eval "$command"
+      done
+    done
+  done
+
+  printf "Evaluating SQLite3 (concurrent streams)...\n"
+  for streams in 2 4 8; do
+    for bloom_filter in "false" "true"; do
+      command="./ssb_sqlite3_mt --streams=$streams --bloom_filter=$bloom_filter"
+      printf "%s\n" "$command"
+      eval "$command"
+    done
+  done
+
+  # One CSV of opcode counts and cycles per query, for analysis/profile.py.
+  printf "Profiling SQLite3...\n"
+  mkdir -p "profiles/sf$sf"
+  ./ssb_sqlite3_vdbe_profile --bloom_filter=false --profile="profiles/sf$sf/vanilla" > /dev/null
+  ./ssb_sqlite3_vdbe_profile --bloom_filter=true --profile="profiles/sf$sf/bloom" > /dev/null
+  # The hardware counters of each query, on the build without profiling.
+  mkdir -p "counters/sf$sf"
+  ./ssb_sqlite3 --bloom_filter=false --counters="counters/sf$sf/vanilla" > /dev/null
+  ./ssb_sqlite3 --bloom_filter=true --counters="counters/sf$sf/bloom" > /dev/null
+
+  # The packed copy of lineorder nearly doubles the database, so only the
+  # database of its own configurations is loaded with it.
+  printf "Loading data with a packed copy of lineorder into SQLite3...\n"
+  printf "part,supplier,customer,date,lineorder,foreign_keys,packed\n"
+  ./ssb_sqlite3 --load --threads=4 --packed=true
+
+  printf "Evaluating SQLite3 (packed)...\n"
+  for hash_join in "false" "true"; do
+    command="./ssb_sqlite3 --packed=true --hash_join=$hash_join"
+    printf "%s\n" "$command"
+    printf "trial,Q1.1,Q1.2,Q1.3,Q2.1,Q2.2,Q2.3,Q3.1,Q3.2,Q3.3,Q3.4,Q4.1,Q4.2,Q4.3\n"
+    for trial in {1..3}; do
+      printf "%s," "$trial"
+      eval "$command"
+    done
+  done
+
+  rm -r ssb.sqlite columnar
 
   printf "Loading data into DuckDB...\n"
-  ./ssb_duckdb --load
+  time ./ssb_duckdb --load
+
+  printf "Loading binary column files into DuckDB...\n"
+  rm -f ssb.duckdb ssb.duckdb.wal
+  time ./ssb_duckdb --load --load_format=col
+
+  printf "Generating data into DuckDB...\n"
+  rm -f ssb.duckdb ssb.duckdb.wal
+  time ./dbgen_duckdb -s "$sf" -f -D -n ssb.duckdb
 
   printf "Evaluating DuckDB...\n"
   for threads in 1 2 4; do
@@ -41,5 +154,14 @@ for sf in 1 2 5; do
     done
   done
 
+  printf "Evaluating DuckDB (concurrent streams)...\n"
+  for streams in 2 4 8; do
+    for threads in 1 4; do
+      command="./ssb_duckdb --run --streams=$streams --threads=$threads"
+      printf "%s\n" "$command"
+      eval "$command"
+    done
+  done
+
   rm ssb.duckdb
 done
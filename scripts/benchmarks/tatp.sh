@@ -18,6 +18,56 @@ for sf in 10000 100000 1000000; do
     done
   done
 
+  # Transactions arrive at a fixed rate, whether or not SQLite keeps up, and
+  # their latencies are measured from their arrival, for a curve of
+  # throughput against tail latency. The latencies go to stderr.
+  printf "Evaluating SQLite3 (open loop)...\n"
+  for journal_mode in "DELETE" "TRUNCATE" "WAL"; do
+    for cache_size in "-100000" "-200000" "-500000" "-1000000" "-2000000" "-5000000"; do
+      for rate in 1000 2000 5000 10000 20000 50000; do
+        command="./tatp_sqlite3 --run --records=$sf --journal_mode=$journal_mode --cache_size=$cache_size --rate=$rate"
+        printf "%s\n" "$command"
+        eval "$command" 2>&1
+      done
+    done
+  done
+
+  # One thread and connection per client, doubling up to the number of
+  # cores.
+  printf "Evaluating SQLite3 (multi-threaded)...\n"
+  clients_list=()
+  for ((clients = 1; clients < $(nproc); clients *= 2)); do
+    clients_list+=("$clients")
+  done
+  clients_list+=("$(nproc)")
+  for cache_size in "-100000" "-1000000"; do
+    command="./tatp_sqlite3_mt --run --records=$sf --journal_mode=WAL --cache_size=$cache_size"
+    printf "%s\n" "$command"
+    printf "clients,throughput\n"
+    for clients in "${clients_list[@]}"; do
+      printf "%s," "$clients"
+      eval "$command --clients=$clients"
+    done
+  done
+
+  # Every commit syncs the WAL, alone or in a group.
+  printf "Evaluating SQLite3 (group commit)...\n"
+  configs=("--synchronous=FULL")
+  for delay in 100 1000 10000; do
+    for batch in 4 16; do
+      configs+=("--group_commit=true --group_commit_delay=$delay --group_commit_batch=$batch")
+    done
+  done
+  for config in "${configs[@]}"; do
+    command="./tatp_sqlite3_mt --run --records=$sf --journal_mode=WAL --clients=$(nproc) $config"
+    printf "%s\n" "$command"
+    printf "trial,throughput,commits_per_fsync\n"
+    for trial in {1..3}; do
+      printf "%s," "$trial"
+      eval "$command"
+    done
+  done
+
   rm tatp.sqlite
 
   printf "Loading data into DuckDB...\n"
@@ -33,5 +83,12 @@ for sf in 10000 100000 1000000; do
     done
   done
 
+  printf "Evaluating DuckDB (open loop)...\n"
+  for rate in 100 200 500 1000 2000 5000; do
+    command="./tatp_duckdb --run --records=$sf --rate=$rate"
+    printf "%s\n" "$command"
+    eval "$command" 2>&1
+  done
+
   rm tatp.duckdb
 done
@@ -0,0 +1,46 @@
+#!/bin/bash
+
+for sf in 1 2 5; do
+  printf "*** TPC-H (scale factor %s) ***\n" "$sf"
+
+  printf "Generating data...\n"
+  rm -f ./*.tbl
+  ./dbgen -s "$sf"
+
+  printf "Loading data into SQLite3...\n"
+  printf "region,nation,part,supplier,partsupp,customer,orders,lineitem,foreign_keys,indexes\n"
+  ./tpch_sqlite3 --load --threads=4
+
+  printf "Evaluating SQLite3...\n"
+  for bloom_filter in "false" "true"; do
+    for cache_size in "-100000" "-200000" "-500000" "-1000000" "-2000000" "-5000000"; do
+      command="./tpch_sqlite3 --bloom_filter=$bloom_filter --cache_size=$cache_size"
+      printf "%s\n" "$command"
+      printf "trial,Q1,Q2,Q3,Q4,Q5,Q6,Q7,Q8,Q9,Q10,Q11,Q12,Q13,Q14,Q15,Q16,Q17,Q18,Q19,Q20,Q21,Q22\n"
+      for trial in {1..3}; do
+        printf "%s," "$trial"
+        eval "$command"
+      done
+    done
+  done
+
+  rm tpch.sqlite
+
+  printf "Loading data into DuckDB...\n"
+  time ./tpch_duckdb --load
+
+  printf "Evaluating DuckDB...\n"
+  for threads in 1 2 4; do
+    for memory_limit in "100MB" "200MB" "500MB" "1GB" "2GB" "5GB"; do
+      command="./tpch_duckdb --run --threads=$threads --memory_limit=$memory_limit"
+      printf "%s\n" "$command"
+      printf "trial,Q1,Q2,Q3,Q4,Q5,Q6,Q7,Q8,Q9,Q10,Q11,Q12,Q13,Q14,Q15,Q16,Q17,Q18,Q19,Q20,Q21,Q22\n"
+      for trial in {1..3}; do
+        printf "%s," "$trial"
+        eval "$command"
+      done
+    done
+  done
+
+  rm tpch.duckdb
+done
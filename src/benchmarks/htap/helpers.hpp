@@ -0,0 +1,153 @@
+#ifndef SQLITE_PERFORMANCE_HTAP_HELPERS_HPP
+#define SQLITE_PERFORMANCE_HTAP_HELPERS_HPP
+
+// TATP writers and SSB readers on one database. The TATP tables and the SSB
+// tables live side by side in the same file. Each workload is first run
+// alone and then both are run at the same time, so that the slowdown of each
+// is measured against its own baseline on the same data.
+
+#include "benchmarks/ssb/helpers.hpp"
+#include "benchmarks/tatp/helpers.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+cxxopts::Options htap_options(const std::string &program,
+                              const std::string &help_string = "") {
+  // --clients is the number of TATP writers.
+  cxxopts::Options options = tatp_options(program, help_string);
+  cxxopts::OptionAdder adder = options.add_options("HTAP");
+  adder("readers", "Number of SSB query streams",
+        cxxopts::value<size_t>()->default_value("1"));
+  return options;
+}
+
+// The TATP throughput and the latencies of the SSB queries during one run.
+struct HtapResults {
+  double throughput = 0;
+  std::map<std::string, std::vector<double>> latencies;
+};
+
+// Runs writers(), which returns the TATP throughput over warmup + measure
+// seconds, while n_readers threads run the SSB queries through
+// query(reader, query) in the order of stream_queries(reader), over and over.
+// Only the queries that start after the warmup are timed. Once the writers
+// return, interrupt(reader) cancels the query in flight, whose latency is not
+// kept.
+template <typename Writers, typename Query, typename Interrupt>
+HtapResults run_htap(size_t n_readers, size_t warmup, Writers &&writers,
+                     Query &&query, Interrupt &&interrupt) {
+  std::vector<std::map<std::string, std::vector<double>>> latencies(
+      n_readers);
+  std::vector<std::string> errors(n_readers);
+  std::atomic<bool> done = false;
+  std::atomic<size_t> running = n_readers;
+
+  auto start = std::chrono::steady_clock::now() + std::chrono::seconds(warmup);
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < n_readers; ++i) {
+    readers.emplace_back([&, i] {
+      std::vector<std::string> queries = stream_queries((int)i);
+      for (size_t j = 0; !done; j = (j + 1) % queries.size()) {
+        bool measured = std::chrono::steady_clock::now() >= start;
+        double latency;
+        try {
+          latency = time([&] { query(i, queries[j]); });
+        } catch (const std::exception &e) {
+          if (!done) {
+            errors[i] = e.what();
+          }
+          break;
+        }
+        if (measured && !done) {
+          latencies[i][queries[j]].push_back(latency);
+        }
+      }
+      --running;
+    });
+  }
+
+  HtapResults results;
+  results.throughput = writers();
+
+  // A query that starts just as the interrupt is sent would run to the end,
+  // so the readers are interrupted until they have all stopped.
+  done = true;
+  while (running > 0) {
+    for (size_t i = 0; i < n_readers; ++i) {
+      interrupt(i);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  for (std::thread &reader : readers) {
+    reader.join();
+  }
+
+  for (const std::string &error : errors) {
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+  }
+
+  for (const auto &reader : latencies) {
+    for (const auto &[query, values] : reader) {
+      std::vector<double> &all = results.latencies[query];
+      all.insert(all.end(), values.begin(), values.end());
+    }
+  }
+  return results;
+}
+
+// Waits as long as the writers would have run, for the readers' baseline.
+double no_writers(size_t warmup, size_t measure) {
+  std::this_thread::sleep_for(std::chrono::seconds(warmup + measure));
+  return 0;
+}
+
+// Prints a row per workload with its result alone, its result mixed with
+// the other workload, and the ratio of the two: the TATP throughput in
+// transactions per second, then the mean latency of each SSB query in
+// seconds. A query that never finished within a run has empty cells.
+void print_htap(const HtapResults &writers_alone,
+                const HtapResults &readers_alone, const HtapResults &mixed) {
+  std::cout << "workload,alone,mixed,ratio" << std::endl;
+  std::cout << "tatp," << writers_alone.throughput << "," << mixed.throughput
+            << "," << mixed.throughput / writers_alone.throughput << std::endl;
+
+  auto mean = [](const HtapResults &results, const std::string &query) {
+    auto it = results.latencies.find(query);
+    if (it == results.latencies.end()) {
+      return 0.0;
+    }
+    double sum = 0;
+    for (double latency : it->second) {
+      sum += latency;
+    }
+    return sum / (double)it->second.size();
+  };
+  for (const std::string &query : ssb_queries) {
+    double alone = mean(readers_alone, query);
+    double during = mean(mixed, query);
+    std::cout << query << ",";
+    if (alone > 0) {
+      std::cout << alone;
+    }
+    std::cout << ",";
+    if (during > 0) {
+      std::cout << during;
+    }
+    std::cout << ",";
+    if (alone > 0 && during > 0) {
+      std::cout << during / alone;
+    }
+    std::cout << std::endl;
+  }
+}
+
+#endif // SQLITE_PERFORMANCE_HTAP_HELPERS_HPP
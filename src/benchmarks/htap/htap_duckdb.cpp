@@ -0,0 +1,88 @@
+#include "benchmarks/tatp/tatp_duckdb.hpp"
+#include "cxxopts.hpp"
+#include "dbbench/runner.hpp"
+#include "helpers.hpp"
+#include "readfile.hpp"
+
+int main(int argc, char **argv) {
+  cxxopts::Options options =
+      htap_options("htap_duckdb", "TATP and SSB on one DuckDB database");
+
+  cxxopts::OptionAdder adder = options.add_options("DuckDB");
+  adder("memory_limit", "Memory limit",
+        cxxopts::value<std::string>()->default_value("1GB"));
+  adder("threads", "Number of threads",
+        cxxopts::value<std::string>()->default_value("1"));
+
+  cxxopts::ParseResult result = options.parse(argc, argv);
+
+  if (result.count("help")) {
+    std::cout << options.help();
+    return 0;
+  }
+
+  auto n_subscriber_records = result["records"].as<uint64_t>();
+  auto memory_limit = result["memory_limit"].as<std::string>();
+  auto threads = result["threads"].as<std::string>();
+  auto n_writers = result["clients"].as<size_t>();
+  auto n_readers = result["readers"].as<size_t>();
+  auto warmup = result["warmup"].as<size_t>();
+  auto measure = result["measure"].as<size_t>();
+
+  duckdb::DuckDB db("htap.duckdb");
+
+  if (result.count("load")) {
+    load(db, n_subscriber_records);
+
+    duckdb::Connection conn(db);
+    assert_success(conn.Query(readfile("sql/init/duckdb.sql")));
+    for (const std::string &table :
+         {"part", "supplier", "customer", "date", "lineorder"}) {
+      assert_success(conn.Query("COPY " + table + " FROM '" + table +
+                                ".tbl' (AUTO_DETECT TRUE)"));
+    }
+  }
+
+  if (result.count("run")) {
+    if (n_writers < 1 || n_readers < 1) {
+      throw std::runtime_error("--clients and --readers must be at least 1");
+    }
+
+    // The memory limit and the threads are settings of the database, shared
+    // by the writers and the readers.
+    duckdb::Connection conn(db);
+    assert_success(conn.Query("PRAGMA memory_limit='" + memory_limit + "'"));
+    assert_success(conn.Query("PRAGMA threads=" + threads));
+
+    std::vector<Worker> workers;
+    for (size_t i = 0; i < n_writers; ++i) {
+      workers.emplace_back(duckdb::Connection(db), n_subscriber_records);
+    }
+
+    std::vector<std::unique_ptr<duckdb::Connection>> readers;
+    for (size_t i = 0; i < n_readers; ++i) {
+      readers.push_back(std::make_unique<duckdb::Connection>(db));
+    }
+
+    std::map<std::string, std::string> sql;
+    for (const std::string &query : ssb_queries) {
+      sql[query] = readfile("sql/" + query + ".sql");
+    }
+
+    auto writers = [&] { return dbbench::run(workers, warmup, measure); };
+    auto query = [&](size_t i, const std::string &name) {
+      assert_success(readers[i]->Query(sql[name]));
+    };
+    auto interrupt = [&](size_t i) { readers[i]->Interrupt(); };
+
+    HtapResults writers_alone = run_htap(0, warmup, writers, query, interrupt);
+    HtapResults readers_alone = run_htap(
+        n_readers, warmup, [&] { return no_writers(warmup, measure); }, query,
+        interrupt);
+    HtapResults mixed = run_htap(n_readers, warmup, writers, query, interrupt);
+
+    print_htap(writers_alone, readers_alone, mixed);
+  }
+
+  return 0;
+}
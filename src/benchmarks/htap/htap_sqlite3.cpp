@@ -0,0 +1,86 @@
+#include "benchmarks/tatp/tatp_sqlite3.hpp"
+#include "cxxopts.hpp"
+#include "dbbench/runner.hpp"
+#include "helpers.hpp"
+#include "readfile.hpp"
+
+int main(int argc, char **argv) {
+  cxxopts::Options options =
+      htap_options("htap_sqlite3", "TATP and SSB on one SQLite3 database");
+
+  cxxopts::OptionAdder adder = options.add_options("SQLite3");
+  adder("cache_size", "Cache size of each connection",
+        cxxopts::value<std::string>()->default_value("-1000000"));
+
+  cxxopts::ParseResult result = options.parse(argc, argv);
+
+  if (result.count("help")) {
+    std::cout << options.help();
+    return 0;
+  }
+
+  auto n_subscriber_records = result["records"].as<uint64_t>();
+  auto cache_size = result["cache_size"].as<std::string>();
+  auto n_writers = result["clients"].as<size_t>();
+  auto n_readers = result["readers"].as<size_t>();
+  auto warmup = result["warmup"].as<size_t>();
+  auto measure = result["measure"].as<size_t>();
+
+  // The SSB tables are loaded by sql/init/sqlite3.sql.
+  sqlite::Database db("htap.sqlite");
+
+  if (result.count("load")) {
+    load(db, n_subscriber_records);
+  }
+
+  if (result.count("run")) {
+    if (n_writers < 1 || n_readers < 1) {
+      throw std::runtime_error("--clients and --readers must be at least 1");
+    }
+
+    // In WAL mode the readers never block the writers, nor the writers the
+    // readers. The writers still take turns to write.
+    auto connect = [&](sqlite::Connection &conn) {
+      db.connect(conn).expect(SQLITE_OK);
+      conn.execute("PRAGMA journal_mode=WAL").expect(SQLITE_OK);
+      conn.execute("PRAGMA cache_size=" + cache_size).expect(SQLITE_OK);
+      conn.execute("PRAGMA busy_timeout=10000").expect(SQLITE_OK);
+    };
+
+    std::vector<Worker> workers;
+    for (size_t i = 0; i < n_writers; ++i) {
+      sqlite::Connection conn;
+      connect(conn);
+      workers.emplace_back(std::move(conn), n_subscriber_records);
+    }
+
+    std::vector<sqlite::Connection> readers(n_readers);
+    for (sqlite::Connection &conn : readers) {
+      connect(conn);
+    }
+    readers[0].execute("ANALYZE").expect(SQLITE_OK);
+
+    std::map<std::string, std::string> sql;
+    for (const std::string &query : ssb_queries) {
+      sql[query] = readfile("sql/" + query + ".sql");
+    }
+
+    auto writers = [&] { return dbbench::run(workers, warmup, measure); };
+    auto query = [&](size_t i, const std::string &name) {
+      readers[i].execute(sql[name]).expect(SQLITE_OK);
+    };
+    auto interrupt = [&](size_t i) {
+      sqlite3_interrupt(readers[i].ptr().get());
+    };
+
+    HtapResults writers_alone = run_htap(0, warmup, writers, query, interrupt);
+    HtapResults readers_alone = run_htap(
+        n_readers, warmup, [&] { return no_writers(warmup, measure); }, query,
+        interrupt);
+    HtapResults mixed = run_htap(n_readers, warmup, writers, query, interrupt);
+
+    print_htap(writers_alone, readers_alone, mixed);
+  }
+
+  return 0;
+}
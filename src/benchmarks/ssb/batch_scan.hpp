@@ -0,0 +1,724 @@
+#ifndef SQLITE_PERFORMANCE_SSB_BATCH_SCAN_HPP
+#define SQLITE_PERFORMANCE_SSB_BATCH_SCAN_HPP
+
+// A virtual table that scans a rowid table of the main schema a batch of rows
+// at a time. Each batch is decoded into column vectors, and the constant
+// comparisons that the planner pushes down are evaluated over the whole batch
+// before any row is handed back to the VDBE:
+//
+//   CREATE VIRTUAL TABLE temp.lineorder USING batch_scan(lineorder);
+//
+// Because the temp schema is searched first, the virtual table shadows the
+// base table and unchanged queries read through it. Only the columns that the
+// statement uses are decoded. Columns must hold INTEGER or TEXT values that
+// match their declared type; anything else is reported as an error.
+//
+// If the module is created with a Bloom filter registry, a batch is also
+// probed against the filters that hash_join publishes for the tables that
+// its foreign keys reference, when the statement joins on them. If the
+// registry asks for it, the hash join probes of the rows left are then
+// prefetched. If the module is created with zone map statistics, constraints
+// on columns that have a zone map (see zone_map.hpp) restrict the scan to the
+// zones that may hold qualifying rows.
+
+#include "bloom_filter.hpp"
+#include "hash_join.hpp"
+#include "sqlite3.h"
+#include "vtab.hpp"
+#include "zone_map.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr size_t batch_size = 1024;
+// How many rows ahead of the row being returned its hash join probes are
+// prefetched.
+constexpr size_t batch_prefetch_distance = 8;
+
+struct Batch {
+  size_t size = 0;
+  std::vector<sqlite3_int64> rowids;
+  std::vector<ColumnVector> columns;
+  // Rows of the batch that satisfy all constraints, in scan order.
+  std::vector<uint16_t> selection;
+  size_t selected = 0;
+};
+
+struct BatchConstraint {
+  int column;
+  unsigned char op;
+  sqlite3_int64 int_value;
+  std::string text_value;
+};
+
+// Narrows sel[0..n) to the rows whose value satisfies `op rhs` and returns the
+// number of rows kept. The loop is branch-free so that the compiler can keep
+// it in registers.
+template <typename T, typename Get>
+size_t batch_select(unsigned char op, const T &rhs, Get &&get, uint16_t *sel,
+                    size_t n) {
+  size_t k = 0;
+  switch (op) {
+  case SQLITE_INDEX_CONSTRAINT_EQ:
+    for (size_t i = 0; i < n; ++i) {
+      sel[k] = sel[i];
+      k += get(sel[i]) == rhs;
+    }
+    break;
+  case SQLITE_INDEX_CONSTRAINT_NE:
+    for (size_t i = 0; i < n; ++i) {
+      sel[k] = sel[i];
+      k += get(sel[i]) != rhs;
+    }
+    break;
+  case SQLITE_INDEX_CONSTRAINT_LT:
+    for (size_t i = 0; i < n; ++i) {
+      sel[k] = sel[i];
+      k += get(sel[i]) < rhs;
+    }
+    break;
+  case SQLITE_INDEX_CONSTRAINT_LE:
+    for (size_t i = 0; i < n; ++i) {
+      sel[k] = sel[i];
+      k += get(sel[i]) <= rhs;
+    }
+    break;
+  case SQLITE_INDEX_CONSTRAINT_GT:
+    for (size_t i = 0; i < n; ++i) {
+      sel[k] = sel[i];
+      k += get(sel[i]) > rhs;
+    }
+    break;
+  case SQLITE_INDEX_CONSTRAINT_GE:
+    for (size_t i = 0; i < n; ++i) {
+      sel[k] = sel[i];
+      k += get(sel[i]) >= rhs;
+    }
+    break;
+  default:
+    k = n;
+  }
+  return k;
+}
+
+struct BatchForeignKey {
+  int column;
+  std::string table;
+};
+
+// The state shared by the tables of a module, passed as its client data.
+struct BatchScanModule {
+  BloomFilterRegistry *filters;
+  ZoneMapStats *zone_maps;
+};
+
+struct BatchScanTable {
+  sqlite3_vtab base;
+  sqlite3 *db;
+  std::string name;
+  VtabColumns columns;
+  double n_rows;
+  BloomFilterRegistry *filters;
+  // Single-column foreign keys that reference an INTEGER PRIMARY KEY, whose
+  // values are the keys of a hash_join build of the referenced table.
+  std::vector<BatchForeignKey> foreign_keys;
+  // The index into foreign_keys of each column, or -1.
+  std::vector<int> foreign_key_of;
+  ZoneMapStats *zone_maps;
+  // The columns that have a zone map.
+  std::vector<bool> zone_mapped;
+};
+
+struct BatchScanCursor {
+  sqlite3_vtab_cursor base;
+  sqlite3_stmt *stmt = nullptr;
+  // Columns decoded into the batch, in statement order after the rowid.
+  std::vector<int> decoded;
+  std::vector<BatchConstraint> constraints;
+  // Bit i is set if the statement joins on foreign_keys[i].
+  int joins = 0;
+  // The slot of the cursor in the Bloom filter registry, or -1.
+  int slot = -1;
+  // The builds that the rows of the batch probe, and the columns they are
+  // probed with, when prefetching. Only valid while the registry counts the
+  // same number of withdrawn builds.
+  std::vector<std::pair<const HashJoinBuild *, int>> prefetches;
+  uint64_t unpublished_builds = 0;
+  // Rowid ranges left to scan after the current one, in reverse order.
+  std::vector<std::pair<sqlite3_int64, sqlite3_int64>> ranges;
+  Batch batch;
+  size_t pos = 0;
+  // Set once the underlying statement has returned SQLITE_DONE; stepping it
+  // again would restart the scan.
+  bool done = true;
+  bool eof = true;
+};
+
+int batch_scan_foreign_keys(BatchScanTable *table, char **pz_err) {
+  sqlite3_stmt *stmt;
+  int rc = sqlite3_prepare_v2(
+      table->db,
+      "SELECT f.\"from\", f.\"table\""
+      " FROM pragma_foreign_key_list(?1, 'main') AS f"
+      " GROUP BY f.id"
+      " HAVING count(*) = 1"
+      " AND (SELECT group_concat(upper(t.type) || ' ' ||"
+      "             (f.\"to\" IS NULL OR f.\"to\" = t.name))"
+      "      FROM pragma_table_info(f.\"table\", 'main') AS t"
+      "      WHERE t.pk > 0) = 'INTEGER 1'",
+      -1, &stmt, nullptr);
+  if (rc != SQLITE_OK) {
+    *pz_err = sqlite3_mprintf("batch_scan: %s", sqlite3_errmsg(table->db));
+    return rc;
+  }
+
+  sqlite3_bind_text(stmt, 1, table->name.c_str(), -1, SQLITE_TRANSIENT);
+  while (sqlite3_step(stmt) == SQLITE_ROW && table->foreign_keys.size() < 31) {
+    auto *from = (const char *)sqlite3_column_text(stmt, 0);
+    const std::vector<std::string> &names = table->columns.names;
+    auto it = std::find(names.begin(), names.end(), from);
+    if (it != names.end() && table->columns.integer[it - names.begin()]) {
+      table->foreign_keys.push_back(
+          {(int)(it - names.begin()),
+           (const char *)sqlite3_column_text(stmt, 1)});
+    }
+  }
+  return sqlite3_finalize(stmt);
+}
+
+int batch_scan_connect(sqlite3 *db, void *aux, int argc,
+                       const char *const *argv, sqlite3_vtab **pp_vtab,
+                       char **pz_err) {
+  if (argc != 4) {
+    *pz_err = sqlite3_mprintf("batch_scan: expected one argument, the table");
+    return SQLITE_ERROR;
+  }
+
+  auto *table = new BatchScanTable();
+  table->db = db;
+  table->name = argv[3];
+  table->filters = ((BatchScanModule *)aux)->filters;
+  table->zone_maps = ((BatchScanModule *)aux)->zone_maps;
+
+  int rc = vtab_columns(db, "batch_scan", table->name, table->columns, pz_err);
+  if (rc == SQLITE_OK && table->filters != nullptr) {
+    rc = batch_scan_foreign_keys(table, pz_err);
+  }
+  table->foreign_key_of.assign(table->columns.names.size(), -1);
+  for (size_t k = 0; k < table->foreign_keys.size(); ++k) {
+    table->foreign_key_of[table->foreign_keys[k].column] = (int)k;
+  }
+  table->zone_mapped.assign(table->columns.names.size(), false);
+  if (rc == SQLITE_OK && table->zone_maps != nullptr) {
+    rc = zone_map_columns(db, table->name, table->columns,
+                          table->zone_mapped);
+    if (rc != SQLITE_OK) {
+      *pz_err = sqlite3_mprintf("batch_scan: %s", sqlite3_errmsg(db));
+    }
+  }
+  if (rc == SQLITE_OK) {
+    rc = vtab_declare(db, table->columns);
+  }
+  if (rc != SQLITE_OK) {
+    delete table;
+    return rc;
+  }
+  table->n_rows = vtab_row_estimate(db, table->name);
+
+  *pp_vtab = &table->base;
+  return SQLITE_OK;
+}
+
+int batch_scan_disconnect(sqlite3_vtab *vtab) {
+  delete (BatchScanTable *)vtab;
+  return SQLITE_OK;
+}
+
+// Pushes down comparisons against constants. The plan is encoded in idxStr as
+// the colUsed mask followed by one "column op" pair per argv entry. Rowid
+// constraints (column -1) narrow the range of the underlying scan, all others
+// are evaluated over each batch. Every pushed constraint is evaluated exactly,
+// so SQLite is told to omit its own check.
+//
+// idxNum has bit i set if foreign_keys[i] is compared for equality with
+// something other than a constant, whether or not SQLite offers the
+// constraint as usable in this plan. That alone does not say what it is
+// compared with, so rows are only dropped by the Bloom filter of the
+// referenced table if its build is probed with the values of the column (see
+// batch_scan_join_filter).
+int batch_scan_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info) {
+  auto *table = (BatchScanTable *)vtab;
+
+  info->idxNum = 0;
+  for (size_t k = 0; k < table->foreign_keys.size(); ++k) {
+    for (int i = 0; i < info->nConstraint; ++i) {
+      const auto &constraint = info->aConstraint[i];
+      sqlite3_value *rhs;
+      if (constraint.iColumn == table->foreign_keys[k].column &&
+          constraint.op == SQLITE_INDEX_CONSTRAINT_EQ &&
+          sqlite3_vtab_rhs_value(info, i, &rhs) != SQLITE_OK) {
+        info->idxNum |= 1 << k;
+      }
+    }
+  }
+
+  std::ostringstream plan;
+  plan << info->colUsed;
+
+  double rows = table->n_rows;
+  double cost = table->n_rows;
+  int argv_index = 0;
+  for (int i = 0; i < info->nConstraint; ++i) {
+    const auto &constraint = info->aConstraint[i];
+    if (!vtab_constant_constraint(info, i, table->columns) ||
+        (constraint.iColumn < 0 &&
+         constraint.op == SQLITE_INDEX_CONSTRAINT_NE)) {
+      continue;
+    }
+
+    info->aConstraintUsage[i].argvIndex = ++argv_index;
+    info->aConstraintUsage[i].omit = 1;
+    plan << " " << constraint.iColumn << " " << (int)constraint.op;
+
+    if (constraint.iColumn < 0) {
+      if (constraint.op == SQLITE_INDEX_CONSTRAINT_EQ) {
+        rows = 1;
+        cost = 1;
+        info->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
+      } else {
+        rows /= 2;
+        cost /= 2;
+      }
+    } else {
+      rows /= constraint.op == SQLITE_INDEX_CONSTRAINT_EQ ? 10 : 3;
+    }
+  }
+
+  info->idxStr = sqlite3_mprintf("%s", plan.str().c_str());
+  info->needToFreeIdxStr = 1;
+  info->estimatedRows = (sqlite3_int64)std::max(1.0, rows);
+  info->estimatedCost = std::max(1.0, cost);
+  return SQLITE_OK;
+}
+
+int batch_scan_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **pp_cursor) {
+  auto *table = (BatchScanTable *)vtab;
+  auto *cursor = new BatchScanCursor();
+  if (table->filters != nullptr) {
+    cursor->slot = table->filters->open_scan();
+  }
+  cursor->batch.rowids.resize(batch_size);
+  cursor->batch.selection.resize(batch_size);
+  *pp_cursor = &cursor->base;
+  return SQLITE_OK;
+}
+
+int batch_scan_close(sqlite3_vtab_cursor *cur) {
+  auto *cursor = (BatchScanCursor *)cur;
+  auto *table = (BatchScanTable *)cur->pVtab;
+  if (table->filters != nullptr) {
+    table->filters->close_scan(cursor->slot);
+  }
+  sqlite3_finalize(cursor->stmt);
+  delete cursor;
+  return SQLITE_OK;
+}
+
+// Called by the underlying statement for every row of the scan, with the
+// cursor bound as a pointer followed by the rowid and the decoded columns.
+// Appending from inside the VDBE means the statement is stepped once per batch
+// rather than once per row. Returns true once the batch is full, which makes
+// the statement yield a row and pause the scan.
+void batch_scan_append(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+  auto *cursor =
+      (BatchScanCursor *)sqlite3_value_pointer(argv[0], "batch_scan");
+  if (cursor == nullptr) {
+    sqlite3_result_error(ctx, "batch_scan_append: no cursor", -1);
+    return;
+  }
+  auto *table = (BatchScanTable *)cursor->base.pVtab;
+  Batch &batch = cursor->batch;
+
+  batch.rowids[batch.size] = sqlite3_value_int64(argv[1]);
+  for (int i = 2; i < argc; ++i) {
+    int column = cursor->decoded[i - 2];
+    ColumnVector &c = batch.columns[column];
+    if (sqlite3_value_type(argv[i]) !=
+        (table->columns.integer[column] ? SQLITE_INTEGER : SQLITE_TEXT)) {
+      char *message = sqlite3_mprintf(
+          "batch_scan: %s.%s holds a value of unexpected type",
+          table->name.c_str(), table->columns.names[column].c_str());
+      sqlite3_result_error(ctx, message, -1);
+      sqlite3_free(message);
+      return;
+    }
+    if (table->columns.integer[column]) {
+      c.ints.push_back(sqlite3_value_int64(argv[i]));
+    } else {
+      auto *text = (const char *)sqlite3_value_text(argv[i]);
+      c.append_text(text, sqlite3_value_bytes(argv[i]));
+    }
+  }
+
+  sqlite3_result_int(ctx, ++batch.size == batch_size);
+}
+
+// The Bloom filter of the table that foreign_keys[k] references, if the
+// statement joins on it and the build of the table has only been probed with
+// the values of the column from this cursor. Those are the only joins that
+// are known to drop the rows that miss the filter.
+const BloomFilter *batch_scan_join_filter(const BatchScanCursor *cursor,
+                                          size_t k) {
+  auto *table = (BatchScanTable *)cursor->base.pVtab;
+  if (!(cursor->joins & (1 << k)) || cursor->slot < 0) {
+    return nullptr;
+  }
+  return table->filters->find(
+      table->foreign_keys[k].table,
+      BloomFilterRegistry::scan_subtype(cursor->slot, (int)k));
+}
+
+// Prefetches the hash join probes of row i of the selection.
+void batch_scan_prefetch(BatchScanCursor *cursor, size_t i) {
+  const Batch &batch = cursor->batch;
+  for (const auto &[build, column] : cursor->prefetches) {
+    hash_join_prefetch(*build, batch.columns[column].ints[batch.selection[i]]);
+  }
+}
+
+// Decodes the next batch from the underlying statement and evaluates the
+// constraints over it. Batches in which no row qualifies are skipped.
+int batch_scan_fill(BatchScanCursor *cursor) {
+  auto *table = (BatchScanTable *)cursor->base.pVtab;
+  Batch &batch = cursor->batch;
+  cursor->pos = 0;
+
+  do {
+    batch.size = 0;
+    for (int column : cursor->decoded) {
+      batch.columns[column].clear();
+    }
+
+    // A batch may span several ranges.
+    while (!cursor->done) {
+      int rc = sqlite3_step(cursor->stmt);
+      if (rc == SQLITE_ROW) {
+        break;
+      } else if (rc != SQLITE_DONE) {
+        table->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(table->db));
+        return rc;
+      } else if (cursor->ranges.empty()) {
+        cursor->done = true;
+      } else {
+        sqlite3_reset(cursor->stmt);
+        sqlite3_bind_int64(cursor->stmt, 1, cursor->ranges.back().first);
+        sqlite3_bind_int64(cursor->stmt, 2, cursor->ranges.back().second);
+        cursor->ranges.pop_back();
+      }
+    }
+
+    size_t n = batch.size;
+    for (size_t i = 0; i < n; ++i) {
+      batch.selection[i] = (uint16_t)i;
+    }
+    batch.selected = n;
+
+    for (const BatchConstraint &constraint : cursor->constraints) {
+      if (constraint.column < 0) {
+        continue;
+      }
+      const ColumnVector &c = batch.columns[constraint.column];
+      if (table->columns.integer[constraint.column]) {
+        const sqlite3_int64 *values = c.ints.data();
+        batch.selected = batch_select(
+            constraint.op, constraint.int_value,
+            [values](uint16_t i) { return values[i]; }, batch.selection.data(),
+            batch.selected);
+      } else {
+        const char *chars = c.chars.data();
+        const uint32_t *offsets = c.offsets.data();
+        const std::string &rhs = constraint.text_value;
+        batch.selected = batch_select(
+            constraint.op, 0,
+            [&](uint16_t i) {
+              size_t size = offsets[i + 1] - offsets[i];
+              int cmp = memcmp(chars + offsets[i], rhs.data(),
+                               std::min(size, rhs.size()));
+              return cmp != 0 ? cmp : (size > rhs.size()) - (size < rhs.size());
+            },
+            batch.selection.data(), batch.selected);
+      }
+    }
+
+    for (size_t k = 0; k < table->foreign_keys.size(); ++k) {
+      if (batch.selected == 0) {
+        continue;
+      }
+      const BloomFilter *filter = batch_scan_join_filter(cursor, k);
+      const ColumnVector &c = batch.columns[table->foreign_keys[k].column];
+      // The first batch is read before the joins have probed, and so before
+      // any build has published a filter.
+      if (filter != nullptr && c.ints.size() == n) {
+        batch.selected = filter->filter(c.ints.data(), batch.selection.data(),
+                                        batch.selected);
+      }
+    }
+
+    // The rows left are probed by the joins as they are returned, one at a
+    // time. batch_scan_next prefetches the probes of a row a fixed distance
+    // ahead of the row it returns; those of the first rows are prefetched
+    // here.
+    cursor->prefetches.clear();
+    if (table->filters != nullptr && table->filters->prefetch) {
+      for (size_t k = 0; k < table->foreign_keys.size(); ++k) {
+        const BatchForeignKey &foreign_key = table->foreign_keys[k];
+        const HashJoinBuild *build =
+            table->filters->find_build(foreign_key.table);
+        if (build != nullptr && batch_scan_join_filter(cursor, k) != nullptr &&
+            batch.columns[foreign_key.column].ints.size() == n) {
+          cursor->prefetches.emplace_back(build, foreign_key.column);
+        }
+      }
+      cursor->unpublished_builds = table->filters->unpublished_builds;
+      for (size_t i = 0;
+           i < std::min(batch.selected, batch_prefetch_distance); ++i) {
+        batch_scan_prefetch(cursor, i);
+      }
+    }
+
+    cursor->eof = n == 0;
+  } while (!cursor->eof && batch.selected == 0);
+
+  return SQLITE_OK;
+}
+
+// Splits [min_rowid, max_rowid] into the ranges of consecutive zones in
+// which every constraint on a zone-mapped column may hold, and stores them in
+// the cursor in reverse order.
+int batch_scan_zones(BatchScanCursor *cursor, sqlite3_int64 min_rowid,
+                     sqlite3_int64 max_rowid) {
+  auto *table = (BatchScanTable *)cursor->base.pVtab;
+  cursor->ranges.clear();
+
+  std::vector<sqlite3_int64> zones;
+  uint64_t n_zones = 0;
+  bool mapped = false;
+  for (const BatchConstraint &constraint : cursor->constraints) {
+    if (constraint.column < 0 || !table->zone_mapped[constraint.column] ||
+        min_rowid > max_rowid) {
+      continue;
+    }
+    uint64_t n;
+    int rc = zone_map_select(
+        table->db, table->name, table->columns.names[constraint.column],
+        constraint.op, constraint.int_value, min_rowid >> zone_map_shift,
+        max_rowid >> zone_map_shift, !mapped, zones, n);
+    if (rc != SQLITE_OK) {
+      table->base.zErrMsg =
+          sqlite3_mprintf("batch_scan: %s", sqlite3_errmsg(table->db));
+      return rc;
+    }
+    n_zones = mapped ? n_zones : n;
+    mapped = true;
+  }
+
+  if (!mapped) {
+    cursor->ranges.emplace_back(min_rowid, max_rowid);
+    return SQLITE_OK;
+  }
+  table->zone_maps->zones += n_zones;
+  table->zone_maps->skipped += n_zones - zones.size();
+
+  for (size_t i = zones.size(); i-- > 0;) {
+    sqlite3_int64 last = zones[i];
+    while (i > 0 && zones[i - 1] == zones[i] - 1) {
+      --i;
+    }
+    sqlite3_int64 first = zones[i];
+    cursor->ranges.emplace_back(
+        std::max(min_rowid, first << zone_map_shift),
+        std::min(max_rowid, ((last + 1) << zone_map_shift) - 1));
+  }
+  return SQLITE_OK;
+}
+
+int batch_scan_filter(sqlite3_vtab_cursor *cur, int idx_num,
+                      const char *idx_str, int argc, sqlite3_value **argv) {
+  auto *cursor = (BatchScanCursor *)cur;
+  auto *table = (BatchScanTable *)cur->pVtab;
+  cursor->joins = idx_num;
+
+  std::istringstream plan(idx_str);
+  sqlite3_uint64 col_used;
+  plan >> col_used;
+
+  cursor->constraints.clear();
+  sqlite3_int64 min_rowid = std::numeric_limits<sqlite3_int64>::min();
+  sqlite3_int64 max_rowid = std::numeric_limits<sqlite3_int64>::max();
+  for (int i = 0; i < argc; ++i) {
+    BatchConstraint constraint;
+    int op;
+    plan >> constraint.column >> op;
+    constraint.op = (unsigned char)op;
+    if (constraint.column >= 0 && !table->columns.integer[constraint.column]) {
+      constraint.text_value.assign(
+          (const char *)sqlite3_value_text(argv[i]),
+          (size_t)sqlite3_value_bytes(argv[i]));
+    } else {
+      constraint.int_value = sqlite3_value_int64(argv[i]);
+    }
+
+    if (constraint.column < 0) {
+      vtab_rowid_range(constraint.op, constraint.int_value, min_rowid,
+                       max_rowid);
+    }
+    cursor->constraints.push_back(std::move(constraint));
+  }
+
+  std::vector<int> decoded;
+  for (size_t column = 0; column < table->columns.names.size(); ++column) {
+    bool used = col_used & ((sqlite3_uint64)1 << std::min<size_t>(column, 63));
+    for (const BatchConstraint &constraint : cursor->constraints) {
+      used = used || constraint.column == (int)column;
+    }
+    if (used) {
+      decoded.push_back((int)column);
+    }
+  }
+
+  if (cursor->stmt == nullptr || decoded != cursor->decoded) {
+    sqlite3_finalize(cursor->stmt);
+    cursor->stmt = nullptr;
+    cursor->decoded = decoded;
+    cursor->batch.columns.assign(table->columns.names.size(), ColumnVector());
+
+    std::ostringstream sql;
+    sql << "SELECT 1 FROM main." << vtab_quote(table->name)
+        << " WHERE rowid BETWEEN ?1 AND ?2 AND batch_scan_append(?3, rowid";
+    for (int column : cursor->decoded) {
+      sql << ", " << vtab_quote(table->columns.names[column]);
+    }
+    sql << ")";
+    int rc = sqlite3_prepare_v2(table->db, sql.str().c_str(), -1,
+                                &cursor->stmt, nullptr);
+    if (rc != SQLITE_OK) {
+      table->base.zErrMsg =
+          sqlite3_mprintf("batch_scan: %s", sqlite3_errmsg(table->db));
+      return rc;
+    }
+  } else {
+    sqlite3_reset(cursor->stmt);
+  }
+
+  int rc = batch_scan_zones(cursor, min_rowid, max_rowid);
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+  cursor->done = cursor->ranges.empty();
+  if (!cursor->done) {
+    sqlite3_bind_int64(cursor->stmt, 1, cursor->ranges.back().first);
+    sqlite3_bind_int64(cursor->stmt, 2, cursor->ranges.back().second);
+    cursor->ranges.pop_back();
+  }
+  sqlite3_bind_pointer(cursor->stmt, 3, cursor, "batch_scan", nullptr);
+  return batch_scan_fill(cursor);
+}
+
+int batch_scan_next(sqlite3_vtab_cursor *cur) {
+  auto *cursor = (BatchScanCursor *)cur;
+  auto *table = (BatchScanTable *)cur->pVtab;
+  if (++cursor->pos < cursor->batch.selected) {
+    if (!cursor->prefetches.empty() &&
+        table->filters->unpublished_builds != cursor->unpublished_builds) {
+      // A build has been withdrawn, and may have been freed.
+      cursor->prefetches.clear();
+    }
+    size_t ahead = cursor->pos + batch_prefetch_distance - 1;
+    if (!cursor->prefetches.empty() && ahead < cursor->batch.selected) {
+      batch_scan_prefetch(cursor, ahead);
+    }
+    return SQLITE_OK;
+  }
+  return batch_scan_fill(cursor);
+}
+
+int batch_scan_eof(sqlite3_vtab_cursor *cur) {
+  return ((BatchScanCursor *)cur)->eof;
+}
+
+int batch_scan_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i) {
+  auto *cursor = (BatchScanCursor *)cur;
+  auto *table = (BatchScanTable *)cur->pVtab;
+  uint16_t row = cursor->batch.selection[cursor->pos];
+  const ColumnVector &c = cursor->batch.columns[i];
+  bool integer = table->columns.integer[i];
+  if ((integer ? c.ints.size() : c.offsets.size() - 1) <= row) {
+    // Not decoded: SQLite only asks for columns outside colUsed when it needs
+    // a placeholder value.
+    sqlite3_result_null(ctx);
+  } else {
+    c.result(ctx, integer, row);
+    int k = table->foreign_key_of[i];
+    if (k >= 0 && cursor->slot >= 0) {
+      sqlite3_result_subtype(
+          ctx, (unsigned)BloomFilterRegistry::scan_subtype(cursor->slot, k));
+    }
+  }
+  return SQLITE_OK;
+}
+
+int batch_scan_rowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid) {
+  auto *cursor = (BatchScanCursor *)cur;
+  *rowid = cursor->batch.rowids[cursor->batch.selection[cursor->pos]];
+  return SQLITE_OK;
+}
+
+sqlite3_module batch_scan_module = {
+    0,                     // iVersion
+    batch_scan_connect,    // xCreate
+    batch_scan_connect,    // xConnect
+    batch_scan_best_index, // xBestIndex
+    batch_scan_disconnect, // xDisconnect
+    batch_scan_disconnect, // xDestroy
+    batch_scan_open,       // xOpen
+    batch_scan_close,      // xClose
+    batch_scan_filter,     // xFilter
+    batch_scan_next,       // xNext
+    batch_scan_eof,        // xEof
+    batch_scan_column,     // xColumn
+    batch_scan_rowid,      // xRowid
+    nullptr,               // xUpdate
+    nullptr,               // xBegin
+    nullptr,               // xSync
+    nullptr,               // xCommit
+    nullptr,               // xRollback
+    nullptr,               // xFindFunction
+    nullptr,               // xRename
+    nullptr,               // xSavepoint
+    nullptr,               // xRelease
+    nullptr,               // xRollbackTo
+    nullptr,               // xShadowName
+};
+
+int create_batch_scan_module(sqlite3 *db,
+                             BloomFilterRegistry *filters = nullptr,
+                             ZoneMapStats *zone_maps = nullptr) {
+  int rc = sqlite3_create_function(db, "batch_scan_append", -1, SQLITE_UTF8,
+                                   nullptr, batch_scan_append, nullptr,
+                                   nullptr);
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+  return sqlite3_create_module_v2(
+      db, "batch_scan", &batch_scan_module,
+      new BatchScanModule{filters, zone_maps},
+      [](void *aux) { delete (BatchScanModule *)aux; });
+}
+
+#endif // SQLITE_PERFORMANCE_SSB_BATCH_SCAN_HPP
@@ -0,0 +1,281 @@
+#ifndef SQLITE_PERFORMANCE_SSB_BLOOM_FILTER_HPP
+#define SQLITE_PERFORMANCE_SSB_BLOOM_FILTER_HPP
+
+// Bloom filters over the keys of a hash join build, probed by the fact table
+// scan to drop rows before they reach the join (lookahead information
+// passing). Two layouts are available so that they can be compared:
+//
+// - flat: the layout of SQLite's OP_Filter. One bit per key, in an array of
+//   eight bits per key. A probe is one random access, but roughly one in nine
+//   misses is a false positive.
+// - blocked: each key sets eight bits within one 64-byte block, so a probe
+//   touches a single cache line. With sixteen bits per key the false positive
+//   rate is below one percent. On CPUs with AVX2, a probe checks all eight
+//   bits with one 256-bit comparison per half block. The AVX2 code is
+//   compiled for that target alone and chosen at run time, so the build
+//   needs no -mavx2.
+//
+// Both are sized from the number of keys in the build, which is known
+// exactly by the time the filter is created.
+
+#include "sqlite3.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define BLOOM_FILTER_AVX2 1
+#endif
+
+enum class BloomFilterLayout { flat, blocked };
+
+class BloomFilter {
+public:
+  BloomFilter(BloomFilterLayout layout, size_t n_keys) : layout_(layout) {
+    size_t bits = n_keys * (layout == BloomFilterLayout::flat ? 8 : 16);
+    size_t n_blocks = 1;
+    while (n_blocks * 512 < bits) {
+      n_blocks *= 2;
+    }
+    blocks_.assign(n_blocks, Block());
+    mask_ = layout == BloomFilterLayout::flat ? n_blocks * 512 - 1
+                                              : n_blocks - 1;
+#if defined(BLOOM_FILTER_AVX2)
+    avx2_ = __builtin_cpu_supports("avx2");
+#endif
+  }
+
+  void insert(sqlite3_int64 key) {
+    uint64_t h = hash(key);
+    if (layout_ == BloomFilterLayout::flat) {
+      size_t bit = h & mask_;
+      blocks_[bit / 512].words[bit / 32 % 16] |= (uint32_t)1 << (bit % 32);
+    } else {
+      uint32_t *words = blocks_[(h >> 32) & mask_].words;
+      for (int i = 0; i < 8; ++i) {
+        uint32_t x = (uint32_t)h * salts[i];
+        words[i + 8 * ((x >> 26) & 1)] |= (uint32_t)1 << (x >> 27);
+      }
+    }
+  }
+
+  bool contains(sqlite3_int64 key) const {
+    uint64_t h = hash(key);
+    if (layout_ == BloomFilterLayout::flat) {
+      return flat_contains(h);
+    }
+    const Block &block = blocks_[(h >> 32) & mask_];
+#if defined(BLOOM_FILTER_AVX2)
+    if (avx2_) {
+      return block_contains_avx2(block, (uint32_t)h);
+    }
+#endif
+    return block_contains(block, (uint32_t)h);
+  }
+
+  // Narrows sel[0..n) to the rows whose key may be in the filter and returns
+  // the number of rows kept.
+  size_t filter(const sqlite3_int64 *keys, uint16_t *sel, size_t n) const {
+    size_t k = 0;
+    if (layout_ == BloomFilterLayout::flat) {
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t h = hash(keys[sel[i]]);
+        sel[k] = sel[i];
+        k += flat_contains(h);
+      }
+#if defined(BLOOM_FILTER_AVX2)
+    } else if (avx2_) {
+      k = filter_avx2(keys, sel, n);
+#endif
+    } else {
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t h = hash(keys[sel[i]]);
+        sel[k] = sel[i];
+        k += block_contains(blocks_[(h >> 32) & mask_], (uint32_t)h);
+      }
+    }
+    return k;
+  }
+
+private:
+  // The flat layout uses the blocks as one bit array.
+  struct alignas(64) Block {
+    uint32_t words[16] = {};
+  };
+
+  static constexpr uint32_t salts[8] = {0x47b6137b, 0x44974d91, 0x8824ad5b,
+                                        0xa2b7289d, 0x705495c7, 0x2df1424b,
+                                        0x9efc4947, 0x5c6bfb31};
+
+  static uint64_t hash(sqlite3_int64 key) {
+    uint64_t h = (uint64_t)key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  bool flat_contains(uint64_t h) const {
+    size_t bit = h & mask_;
+    return (blocks_[bit / 512].words[bit / 32 % 16] >> (bit % 32)) & 1;
+  }
+
+  // Salt i selects bit x >> 27 of word i or word i + 8 of the block.
+  static bool block_contains(const Block &block, uint32_t h) {
+    bool found = true;
+    for (int i = 0; i < 8; ++i) {
+      uint32_t x = h * salts[i];
+      found &= (block.words[i + 8 * ((x >> 26) & 1)] >> (x >> 27)) & 1;
+    }
+    return found;
+  }
+
+#if defined(BLOOM_FILTER_AVX2)
+  __attribute__((target("avx2"))) static bool
+  block_contains_avx2(const Block &block, uint32_t h) {
+    const __m256i salt = _mm256_loadu_si256((const __m256i *)salts);
+    __m256i x = _mm256_mullo_epi32(_mm256_set1_epi32((int)h), salt);
+    __m256i bits = _mm256_sllv_epi32(_mm256_set1_epi32(1),
+                                     _mm256_srli_epi32(x, 27));
+    __m256i high = _mm256_srai_epi32(_mm256_slli_epi32(x, 5), 31);
+    __m256i lo = _mm256_andnot_si256(high, bits);
+    __m256i hi = _mm256_and_si256(high, bits);
+    const auto *words = (const __m256i *)block.words;
+    return _mm256_testc_si256(_mm256_load_si256(words), lo) &
+           _mm256_testc_si256(_mm256_load_si256(words + 1), hi);
+  }
+
+  // The blocked loop of filter(), compiled for AVX2 as a whole so that the
+  // probes are inlined into it.
+  __attribute__((target("avx2"))) size_t
+  filter_avx2(const sqlite3_int64 *keys, uint16_t *sel, size_t n) const {
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t h = hash(keys[sel[i]]);
+      sel[k] = sel[i];
+      k += block_contains_avx2(blocks_[(h >> 32) & mask_], (uint32_t)h);
+    }
+    return k;
+  }
+#endif
+
+  BloomFilterLayout layout_;
+  std::vector<Block> blocks_;
+  size_t mask_;
+  bool avx2_ = false;
+};
+
+struct HashJoinBuild;
+
+// The Bloom filters that the hash joins of the running statement publish for
+// the scans, by the name of the table they were built from. With prefetch
+// set, the hash joins also publish their builds, so that a scan can prefetch
+// what the probes for the rows that pass the filters will read.
+//
+// A filter only tells which rows of a scan cannot join if the build is probed
+// with the values of the column that the scan filters on. So a scan gives the
+// values of its foreign keys a subtype that names the scan and the column,
+// and a hash join records the subtype of the keys it is probed with.
+struct BloomFilterRegistry {
+  BloomFilterLayout layout = BloomFilterLayout::flat;
+  bool prefetch = false;
+  std::map<std::string, std::vector<const BloomFilter *>> filters;
+  std::map<std::string, std::vector<const HashJoinBuild *>> builds;
+  // The subtype of the keys that the build of each published filter has been
+  // probed with, or -1 once it has been probed with a key that had another
+  // subtype or none.
+  std::map<const BloomFilter *, int> probes;
+  // A bit per scan slot in use.
+  unsigned scans = 0;
+  // The number of builds withdrawn so far, for a scan to tell whether the
+  // builds it holds on to are still published.
+  uint64_t unpublished_builds = 0;
+
+  // The subtype of the values of foreign key k, fewer than 32, of the scan in
+  // slot. The high bit keeps it clear of the subtypes of SQLite's JSON
+  // functions.
+  static int scan_subtype(int slot, int k) { return 0x80 | slot << 5 | k; }
+
+  // A slot for a scan, or -1 if all four are in use.
+  int open_scan() {
+    for (int slot = 0; slot < 4; ++slot) {
+      if (!(scans & 1u << slot)) {
+        scans |= 1u << slot;
+        return slot;
+      }
+    }
+    return -1;
+  }
+
+  void close_scan(int slot) {
+    if (slot >= 0) {
+      scans &= ~(1u << slot);
+    }
+  }
+
+  void publish(const std::string &table, const BloomFilter *filter) {
+    filters[table].push_back(filter);
+  }
+
+  void unpublish(const std::string &table, const BloomFilter *filter) {
+    std::vector<const BloomFilter *> &published = filters[table];
+    for (size_t i = 0; i < published.size(); ++i) {
+      if (published[i] == filter) {
+        published.erase(published.begin() + (long)i);
+        break;
+      }
+    }
+    probes.erase(filter);
+  }
+
+  // The filter built from the table, or null unless exactly one is
+  // published. Two builds of the same table may have been made for different
+  // predicates, and a row is only known to be useless if neither matches.
+  const BloomFilter *find(const std::string &table) const {
+    auto it = filters.find(table);
+    if (it == filters.end() || it->second.size() != 1) {
+      return nullptr;
+    }
+    return it->second[0];
+  }
+
+  // The filter built from the table, if its build has only been probed with
+  // keys of the subtype.
+  const BloomFilter *find(const std::string &table, int subtype) const {
+    const BloomFilter *filter = find(table);
+    auto it = probes.find(filter);
+    if (filter == nullptr || it == probes.end() || it->second != subtype) {
+      return nullptr;
+    }
+    return filter;
+  }
+
+  void publish_build(const std::string &table, const HashJoinBuild *build) {
+    builds[table].push_back(build);
+  }
+
+  void unpublish_build(const std::string &table, const HashJoinBuild *build) {
+    std::vector<const HashJoinBuild *> &published = builds[table];
+    published.erase(std::remove(published.begin(), published.end(), build),
+                    published.end());
+    ++unpublished_builds;
+  }
+
+  // The build of the table, or null unless exactly one is published.
+  const HashJoinBuild *find_build(const std::string &table) const {
+    auto it = builds.find(table);
+    if (it == builds.end() || it->second.size() != 1) {
+      return nullptr;
+    }
+    return it->second[0];
+  }
+};
+
+#endif // SQLITE_PERFORMANCE_SSB_BLOOM_FILTER_HPP
@@ -0,0 +1,163 @@
+#ifndef SQLITE_PERFORMANCE_SSB_COLFILE_HPP
+#define SQLITE_PERFORMANCE_SSB_COLFILE_HPP
+
+// Reading of the binary column files of dbgen -D (dbgen/colfile.h). Each
+// column of a table is mapped, and the loaders take the values of a row from
+// cursors that move through the columns in table order, so a value is bound
+// straight from the mapping without any parsing.
+
+#include "benchmarks/ssb/dbgen/colfile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A read-only mapping of a whole file.
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      throw std::runtime_error("Cannot stat " + path);
+    }
+    size_ = (size_t)st.st_size;
+    if (size_ > 0) {
+      map_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map_ == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Cannot map " + path);
+      }
+      madvise(map_, size_, MADV_SEQUENTIAL);
+    }
+    close(fd);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+    if (map_ != MAP_FAILED) {
+      munmap(map_, size_);
+    }
+  }
+
+  const char *data() const {
+    return map_ != MAP_FAILED ? (const char *)map_ : "";
+  }
+  size_t size() const { return size_; }
+
+private:
+  void *map_ = MAP_FAILED;
+  size_t size_ = 0;
+};
+
+// The column files of a table, with a cursor per column.
+class ColTable {
+public:
+  // Maps <table>.<i>.col for every column of the table, whose number is
+  // given by the header of column 0, and checks that the headers agree.
+  explicit ColTable(const std::string &table) {
+    colfile_header_t first = open_column(table, 0);
+    n_columns_ = first.n_columns;
+    rows_ = first.rows;
+    for (uint32_t i = 1; i < n_columns_; ++i) {
+      colfile_header_t header = open_column(table, i);
+      if (header.n_columns != n_columns_ || header.rows != rows_) {
+        throw std::runtime_error(path(table, i) + " does not match " +
+                                 path(table, 0));
+      }
+    }
+  }
+
+  size_t n_columns() const { return n_columns_; }
+  uint64_t rows() const { return rows_; }
+  bool integer(size_t column) const {
+    return columns_[column].type == COLFILE_INT;
+  }
+
+  // The next value of an integer column.
+  int64_t next_int(size_t column) {
+    Column &c = columns_[column];
+    int64_t value;
+    std::memcpy(&value, c.cursor, sizeof(value));
+    c.cursor += sizeof(value);
+    return value;
+  }
+
+  // The next value of a string column, which points into the mapping.
+  std::string_view next_str(size_t column) {
+    Column &c = columns_[column];
+    uint32_t size;
+    if ((size_t)(c.end - c.cursor) < sizeof(size)) {
+      throw std::runtime_error("Truncated column file");
+    }
+    std::memcpy(&size, c.cursor, sizeof(size));
+    c.cursor += sizeof(size);
+    if ((size_t)(c.end - c.cursor) < size) {
+      throw std::runtime_error("Truncated column file");
+    }
+    std::string_view value(c.cursor, size);
+    c.cursor += size;
+    return value;
+  }
+
+private:
+  struct Column {
+    std::unique_ptr<MappedFile> file;
+    uint32_t type;
+    const char *cursor;
+    const char *end;
+  };
+
+  static std::string path(const std::string &table, uint32_t column) {
+    return table + "." + std::to_string(column) + COLFILE_SUFFIX;
+  }
+
+  colfile_header_t open_column(const std::string &table, uint32_t column) {
+    auto file = std::make_unique<MappedFile>(path(table, column));
+    colfile_header_t header;
+    if (file->size() < sizeof(header)) {
+      throw std::runtime_error(path(table, column) + " has no header");
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, COLFILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.column != column ||
+        (header.type != COLFILE_INT && header.type != COLFILE_STR)) {
+      throw std::runtime_error(path(table, column) +
+                               " is not a column file of dbgen");
+    }
+    // Integer columns are checked once here, so next_int() needs no check.
+    if (header.type == COLFILE_INT &&
+        file->size() != sizeof(header) + header.rows * sizeof(int64_t)) {
+      throw std::runtime_error(path(table, column) + " is truncated");
+    }
+
+    Column c;
+    c.type = header.type;
+    c.cursor = file->data() + sizeof(header);
+    c.end = file->data() + file->size();
+    c.file = std::move(file);
+    columns_.push_back(std::move(c));
+    return header;
+  }
+
+  std::vector<Column> columns_;
+  uint32_t n_columns_ = 0;
+  uint64_t rows_ = 0;
+};
+
+#endif // SQLITE_PERFORMANCE_SSB_COLFILE_HPP
@@ -0,0 +1,775 @@
+#ifndef SQLITE_PERFORMANCE_SSB_COLUMNAR_HPP
+#define SQLITE_PERFORMANCE_SSB_COLUMNAR_HPP
+
+// A virtual table that stores a table of the main schema column by column,
+// in one compressed segment file per column:
+//
+//   CREATE VIRTUAL TABLE temp.lineorder USING columnar(lineorder, columnar);
+//
+// The second argument is the directory of the segment files. The segments
+// are written from main.<table> when the virtual table is created if any of
+// them is missing, or if they hold another number of rows than the table,
+// as they do after the table has been loaded again.
+//
+// A segment holds the values of its column in blocks of batch_size rows. Each
+// block stores its minimum and maximum, and every value as its difference
+// from the minimum in 0, 1, 2, 4 or 8 bytes (frame of reference). TEXT
+// columns are dictionary encoded: their distinct values are stored once, in
+// sorted order, and the blocks hold codes into the dictionary. The rowids
+// have a segment of their own. Segment files are mapped into memory.
+//
+// Constant constraints are pushed down as in batch_scan. A block is skipped
+// without being decoded if the bounds of a constrained column rule it out.
+// Otherwise the constraints are evaluated one column at a time, on codes for
+// TEXT columns, and each column is decoded only for the rows that are still
+// selected. Columns the statement does not use are never read.
+
+#include "batch_scan.hpp"
+#include "sqlite3.h"
+#include "vtab.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Segment file layout, in native byte order:
+//
+//   uint64_t n_rows
+//   uint32_t n_values, then per dictionary value its uint32_t size and bytes
+//   per block: int64_t min, int64_t max, uint8_t width, width bytes per row
+
+struct ColumnarBlock {
+  sqlite3_int64 min;
+  sqlite3_int64 max;
+  int width;
+  const unsigned char *data;
+};
+
+struct ColumnarSegment {
+  void *map = MAP_FAILED;
+  size_t size = 0;
+  uint64_t n_rows = 0;
+  std::vector<std::string> dictionary;
+  std::vector<ColumnarBlock> blocks;
+
+  ColumnarSegment() = default;
+  ColumnarSegment(const ColumnarSegment &) = delete;
+  ColumnarSegment &operator=(const ColumnarSegment &) = delete;
+
+  ~ColumnarSegment() {
+    if (map != MAP_FAILED) {
+      munmap(map, size);
+    }
+  }
+};
+
+// Reads a value and advances p past it, unless that would pass end.
+template <typename T>
+bool columnar_read(const unsigned char *&p, const unsigned char *end,
+                   T &value) {
+  if ((size_t)(end - p) < sizeof(T)) {
+    return false;
+  }
+  memcpy(&value, p, sizeof(T));
+  p += sizeof(T);
+  return true;
+}
+
+int columnar_open_segment(const std::string &path, ColumnarSegment &segment) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return SQLITE_CANTOPEN;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return SQLITE_CORRUPT;
+  }
+  segment.size = (size_t)st.st_size;
+  segment.map = mmap(nullptr, segment.size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (segment.map == MAP_FAILED) {
+    return SQLITE_IOERR;
+  }
+
+  const auto *p = (const unsigned char *)segment.map;
+  const unsigned char *end = p + segment.size;
+  uint32_t n_values;
+  if (!columnar_read(p, end, segment.n_rows) ||
+      !columnar_read(p, end, n_values)) {
+    return SQLITE_CORRUPT;
+  }
+  for (uint32_t i = 0; i < n_values; ++i) {
+    uint32_t size;
+    if (!columnar_read(p, end, size) || (size_t)(end - p) < size) {
+      return SQLITE_CORRUPT;
+    }
+    segment.dictionary.emplace_back((const char *)p, size);
+    p += size;
+  }
+
+  for (uint64_t first = 0; first < segment.n_rows; first += batch_size) {
+    ColumnarBlock block;
+    uint8_t width;
+    if (!columnar_read(p, end, block.min) ||
+        !columnar_read(p, end, block.max) || !columnar_read(p, end, width) ||
+        (width != 0 && width != 1 && width != 2 && width != 4 && width != 8)) {
+      return SQLITE_CORRUPT;
+    }
+    size_t size = std::min<uint64_t>(batch_size, segment.n_rows - first) *
+                  width;
+    if ((size_t)(end - p) < size) {
+      return SQLITE_CORRUPT;
+    }
+    block.width = width;
+    block.data = p;
+    segment.blocks.push_back(block);
+    p += size;
+  }
+  return p == end ? SQLITE_OK : SQLITE_CORRUPT;
+}
+
+template <typename T>
+void columnar_unpack(const ColumnarBlock &block, const uint16_t *sel,
+                     size_t n, sqlite3_int64 *out) {
+  for (size_t i = 0; i < n; ++i) {
+    T delta;
+    memcpy(&delta, block.data + sel[i] * sizeof(T), sizeof(T));
+    out[sel[i]] = (sqlite3_int64)((uint64_t)block.min + delta);
+  }
+}
+
+// Decodes the rows sel[0..n) of a block into out, indexed by row.
+void columnar_decode(const ColumnarBlock &block, const uint16_t *sel, size_t n,
+                     sqlite3_int64 *out) {
+  switch (block.width) {
+  case 0:
+    for (size_t i = 0; i < n; ++i) {
+      out[sel[i]] = block.min;
+    }
+    break;
+  case 1:
+    columnar_unpack<uint8_t>(block, sel, n, out);
+    break;
+  case 2:
+    columnar_unpack<uint16_t>(block, sel, n, out);
+    break;
+  case 4:
+    columnar_unpack<uint32_t>(block, sel, n, out);
+    break;
+  default:
+    columnar_unpack<uint64_t>(block, sel, n, out);
+  }
+}
+
+// Writes a segment file one block at a time.
+class ColumnarWriter {
+public:
+  ColumnarWriter(const std::string &path,
+                 const std::vector<std::string> &dictionary)
+      : out_(path, std::ios::binary | std::ios::trunc) {
+    write(n_rows_);
+    write((uint32_t)dictionary.size());
+    for (const std::string &value : dictionary) {
+      write((uint32_t)value.size());
+      out_.write(value.data(), (std::streamsize)value.size());
+    }
+  }
+
+  void append(sqlite3_int64 value) {
+    block_.push_back(value);
+    if (block_.size() == batch_size) {
+      flush();
+    }
+  }
+
+  // Writes the last block and the number of rows, and returns whether the
+  // whole file was written.
+  bool finish() {
+    flush();
+    out_.seekp(0);
+    write(n_rows_);
+    out_.close();
+    return !out_.fail();
+  }
+
+private:
+  template <typename T> void write(T value) {
+    out_.write((const char *)&value, sizeof(T));
+  }
+
+  template <typename T> void pack(sqlite3_int64 min) {
+    for (sqlite3_int64 value : block_) {
+      write((T)((uint64_t)value - (uint64_t)min));
+    }
+  }
+
+  void flush() {
+    if (block_.empty()) {
+      return;
+    }
+    auto bounds = std::minmax_element(block_.begin(), block_.end());
+    sqlite3_int64 min = *bounds.first;
+    sqlite3_int64 max = *bounds.second;
+    uint64_t range = (uint64_t)max - (uint64_t)min;
+    uint8_t width = range == 0            ? 0
+                    : range <= UINT8_MAX  ? 1
+                    : range <= UINT16_MAX ? 2
+                    : range <= UINT32_MAX ? 4
+                                          : 8;
+    write(min);
+    write(max);
+    write(width);
+    switch (width) {
+    case 1:
+      pack<uint8_t>(min);
+      break;
+    case 2:
+      pack<uint16_t>(min);
+      break;
+    case 4:
+      pack<uint32_t>(min);
+      break;
+    case 8:
+      pack<uint64_t>(min);
+      break;
+    }
+    n_rows_ += block_.size();
+    block_.clear();
+  }
+
+  std::ofstream out_;
+  uint64_t n_rows_ = 0;
+  std::vector<sqlite3_int64> block_;
+};
+
+// The rowid segment, then one segment per column.
+std::vector<std::string> columnar_paths(const std::string &directory,
+                                        const std::string &table,
+                                        const VtabColumns &columns) {
+  std::vector<std::string> paths = {directory + "/" + table + ".rowid.seg"};
+  for (const std::string &name : columns.names) {
+    paths.push_back(directory + "/" + table + "." + name + ".seg");
+  }
+  return paths;
+}
+
+// Writes the segments of main.<table>. Each file is written under a
+// temporary name and renamed once complete, so that an interrupted build is
+// not mistaken for a segment.
+int columnar_build(sqlite3 *db, const std::string &table,
+                   const VtabColumns &columns,
+                   const std::vector<std::string> &paths, char **pz_err) {
+  size_t n_columns = columns.names.size();
+  std::vector<std::vector<std::string>> dictionaries(n_columns);
+  std::vector<std::unordered_map<std::string, sqlite3_int64>> codes(n_columns);
+  int rc = SQLITE_OK;
+  for (size_t i = 0; i < n_columns && rc == SQLITE_OK; ++i) {
+    if (columns.integer[i]) {
+      continue;
+    }
+    std::string column = vtab_quote(columns.names[i]);
+    std::string sql = "SELECT DISTINCT " + column + " FROM main." +
+                      vtab_quote(table) + " WHERE typeof(" + column +
+                      ") = 'text' ORDER BY 1";
+    sqlite3_stmt *stmt;
+    rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+      break;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      std::string value((const char *)sqlite3_column_text(stmt, 0),
+                        (size_t)sqlite3_column_bytes(stmt, 0));
+      codes[i].emplace(value, (sqlite3_int64)dictionaries[i].size());
+      dictionaries[i].push_back(std::move(value));
+    }
+    rc = sqlite3_finalize(stmt);
+  }
+
+  std::ostringstream sql;
+  sql << "SELECT rowid";
+  for (const std::string &name : columns.names) {
+    sql << ", " << vtab_quote(name);
+  }
+  sql << " FROM main." << vtab_quote(table);
+  sqlite3_stmt *stmt = nullptr;
+  if (rc == SQLITE_OK) {
+    rc = sqlite3_prepare_v2(db, sql.str().c_str(), -1, &stmt, nullptr);
+  }
+  if (rc != SQLITE_OK) {
+    *pz_err = sqlite3_mprintf("columnar: %s", sqlite3_errmsg(db));
+    return rc;
+  }
+
+  std::vector<std::unique_ptr<ColumnarWriter>> writers;
+  writers.emplace_back(new ColumnarWriter(paths[0] + ".tmp", {}));
+  for (size_t i = 0; i < n_columns; ++i) {
+    writers.emplace_back(
+        new ColumnarWriter(paths[i + 1] + ".tmp", dictionaries[i]));
+  }
+
+  std::string key;
+  while (rc == SQLITE_OK && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    rc = SQLITE_OK;
+    writers[0]->append(sqlite3_column_int64(stmt, 0));
+    for (size_t i = 0; i < n_columns; ++i) {
+      int column = (int)i + 1;
+      if (sqlite3_column_type(stmt, column) !=
+          (columns.integer[i] ? SQLITE_INTEGER : SQLITE_TEXT)) {
+        *pz_err = sqlite3_mprintf(
+            "columnar: %s.%s holds a value of unexpected type", table.c_str(),
+            columns.names[i].c_str());
+        rc = SQLITE_ERROR;
+        break;
+      }
+      if (columns.integer[i]) {
+        writers[i + 1]->append(sqlite3_column_int64(stmt, column));
+      } else {
+        key.assign((const char *)sqlite3_column_text(stmt, column),
+                   (size_t)sqlite3_column_bytes(stmt, column));
+        writers[i + 1]->append(codes[i].at(key));
+      }
+    }
+  }
+  if (rc == SQLITE_DONE) {
+    rc = SQLITE_OK;
+  } else if (rc != SQLITE_ERROR) {
+    *pz_err = sqlite3_mprintf("columnar: %s", sqlite3_errmsg(db));
+  }
+  sqlite3_finalize(stmt);
+
+  for (size_t i = 0; i < writers.size(); ++i) {
+    std::string temporary = paths[i] + ".tmp";
+    if (!writers[i]->finish() && rc == SQLITE_OK) {
+      *pz_err = sqlite3_mprintf("columnar: cannot write %s", temporary.c_str());
+      rc = SQLITE_IOERR;
+    }
+    if (rc == SQLITE_OK) {
+      std::rename(temporary.c_str(), paths[i].c_str());
+    } else {
+      std::remove(temporary.c_str());
+    }
+  }
+  return rc;
+}
+
+// The number of rows in the header of the segment at path, or -1 if it
+// cannot be read.
+sqlite3_int64 columnar_segment_rows(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  uint64_t n_rows;
+  if (!in.read((char *)&n_rows, sizeof(n_rows))) {
+    return -1;
+  }
+  return (sqlite3_int64)n_rows;
+}
+
+// Sets stale to whether the segments at paths are missing or were written
+// from another number of rows than main.<table> holds.
+int columnar_stale(sqlite3 *db, const std::string &table,
+                   const std::vector<std::string> &paths, bool &stale) {
+  std::string sql = "SELECT count(*) FROM main." + vtab_quote(table);
+  sqlite3_stmt *stmt;
+  int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+  sqlite3_int64 n_rows = -1;
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    n_rows = sqlite3_column_int64(stmt, 0);
+  }
+  rc = sqlite3_finalize(stmt);
+  stale = std::any_of(paths.begin(), paths.end(), [&](const std::string &path) {
+    return columnar_segment_rows(path) != n_rows;
+  });
+  return rc;
+}
+
+struct ColumnarConstraint {
+  // -1 for the rowid.
+  int column;
+  unsigned char op;
+  sqlite3_int64 int_value;
+  // For TEXT columns, whether each dictionary value satisfies the constraint,
+  // and the number of values below each code that do.
+  std::vector<uint8_t> match;
+  std::vector<uint32_t> matches_below;
+};
+
+struct ColumnarTable {
+  sqlite3_vtab base;
+  VtabColumns columns;
+  // The rowid segment, then one segment per column.
+  std::vector<std::unique_ptr<ColumnarSegment>> segments;
+  uint64_t n_rows;
+};
+
+struct ColumnarCursor {
+  sqlite3_vtab_cursor base;
+  std::vector<ColumnarConstraint> constraints;
+  // Segments the statement reads, other than those of the constraints.
+  std::vector<int> used;
+  size_t next_block = 0;
+  size_t block = 0;
+  // Values of the current block by segment and row, valid for the selected
+  // rows of the segments that are marked decoded.
+  std::vector<std::vector<sqlite3_int64>> values;
+  std::vector<bool> decoded;
+  std::vector<uint16_t> selection;
+  size_t selected = 0;
+  size_t pos = 0;
+  bool eof = true;
+};
+
+int columnar_connect(sqlite3 *db, void *, int argc, const char *const *argv,
+                     sqlite3_vtab **pp_vtab, char **pz_err) {
+  if (argc != 5) {
+    *pz_err = sqlite3_mprintf(
+        "columnar: expected two arguments, the table and the directory");
+    return SQLITE_ERROR;
+  }
+  std::string name = vtab_dequote(argv[3]);
+  std::string directory = vtab_dequote(argv[4]);
+
+  auto *table = new ColumnarTable();
+  int rc = vtab_columns(db, "columnar", name, table->columns, pz_err);
+  std::vector<std::string> paths =
+      columnar_paths(directory, name, table->columns);
+  bool stale = false;
+  if (rc == SQLITE_OK) {
+    rc = columnar_stale(db, name, paths, stale);
+    if (rc != SQLITE_OK) {
+      *pz_err = sqlite3_mprintf("columnar: %s", sqlite3_errmsg(db));
+    }
+  }
+  if (rc == SQLITE_OK && stale) {
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+      *pz_err = sqlite3_mprintf("columnar: cannot create %s",
+                                directory.c_str());
+      rc = SQLITE_CANTOPEN;
+    } else {
+      rc = columnar_build(db, name, table->columns, paths, pz_err);
+    }
+  }
+  for (size_t i = 0; i < paths.size() && rc == SQLITE_OK; ++i) {
+    table->segments.emplace_back(new ColumnarSegment());
+    rc = columnar_open_segment(paths[i], *table->segments.back());
+    if (rc == SQLITE_OK &&
+        table->segments.back()->n_rows != table->segments[0]->n_rows) {
+      rc = SQLITE_CORRUPT;
+    }
+    if (rc != SQLITE_OK) {
+      *pz_err = sqlite3_mprintf("columnar: cannot read %s", paths[i].c_str());
+    }
+  }
+  if (rc == SQLITE_OK) {
+    rc = vtab_declare(db, table->columns);
+  }
+  if (rc != SQLITE_OK) {
+    delete table;
+    return rc;
+  }
+  table->n_rows = table->segments[0]->n_rows;
+
+  *pp_vtab = &table->base;
+  return SQLITE_OK;
+}
+
+int columnar_disconnect(sqlite3_vtab *vtab) {
+  delete (ColumnarTable *)vtab;
+  return SQLITE_OK;
+}
+
+// The plan is encoded in idxStr as in batch_scan: the colUsed mask followed
+// by one "column op" pair per argv entry.
+int columnar_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info) {
+  auto *table = (ColumnarTable *)vtab;
+
+  std::ostringstream plan;
+  plan << info->colUsed;
+
+  double rows = (double)table->n_rows;
+  double cost = (double)table->n_rows;
+  int argv_index = 0;
+  for (int i = 0; i < info->nConstraint; ++i) {
+    const auto &constraint = info->aConstraint[i];
+    if (!vtab_constant_constraint(info, i, table->columns)) {
+      continue;
+    }
+
+    info->aConstraintUsage[i].argvIndex = ++argv_index;
+    info->aConstraintUsage[i].omit = 1;
+    plan << " " << constraint.iColumn << " " << (int)constraint.op;
+
+    if (constraint.iColumn < 0 &&
+        constraint.op == SQLITE_INDEX_CONSTRAINT_EQ) {
+      // Every block but one is skipped on its bounds.
+      rows = 1;
+      cost = (double)(table->n_rows / batch_size + batch_size);
+      info->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
+    } else if (constraint.iColumn < 0 &&
+               constraint.op != SQLITE_INDEX_CONSTRAINT_NE) {
+      rows /= 2;
+      cost /= 2;
+    } else {
+      rows /= constraint.op == SQLITE_INDEX_CONSTRAINT_EQ ? 10 : 3;
+    }
+  }
+
+  info->idxStr = sqlite3_mprintf("%s", plan.str().c_str());
+  info->needToFreeIdxStr = 1;
+  info->estimatedRows = (sqlite3_int64)std::max(1.0, rows);
+  info->estimatedCost = std::max(1.0, cost);
+  return SQLITE_OK;
+}
+
+int columnar_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **pp_cursor) {
+  auto *table = (ColumnarTable *)vtab;
+  auto *cursor = new ColumnarCursor();
+  cursor->values.assign(table->segments.size(),
+                        std::vector<sqlite3_int64>(batch_size));
+  cursor->decoded.assign(table->segments.size(), false);
+  cursor->selection.resize(batch_size);
+  *pp_cursor = &cursor->base;
+  return SQLITE_OK;
+}
+
+int columnar_close(sqlite3_vtab_cursor *cur) {
+  delete (ColumnarCursor *)cur;
+  return SQLITE_OK;
+}
+
+// Whether the block may hold a row that satisfies the constraint, judged by
+// its bounds. Codes are compared as the values they stand for.
+bool columnar_may_match(const ColumnarConstraint &constraint,
+                        const ColumnarBlock &block, bool integer) {
+  if (!integer) {
+    return constraint.matches_below[block.max + 1] >
+           constraint.matches_below[block.min];
+  }
+  sqlite3_int64 v = constraint.int_value;
+  switch (constraint.op) {
+  case SQLITE_INDEX_CONSTRAINT_EQ:
+    return block.min <= v && v <= block.max;
+  case SQLITE_INDEX_CONSTRAINT_NE:
+    return block.min != v || block.max != v;
+  case SQLITE_INDEX_CONSTRAINT_LT:
+    return block.min < v;
+  case SQLITE_INDEX_CONSTRAINT_LE:
+    return block.min <= v;
+  case SQLITE_INDEX_CONSTRAINT_GT:
+    return block.max > v;
+  case SQLITE_INDEX_CONSTRAINT_GE:
+    return block.max >= v;
+  default:
+    return true;
+  }
+}
+
+void columnar_decode_segment(ColumnarCursor *cursor, int segment) {
+  auto *table = (ColumnarTable *)cursor->base.pVtab;
+  if (!cursor->decoded[segment]) {
+    columnar_decode(table->segments[segment]->blocks[cursor->block],
+                    cursor->selection.data(), cursor->selected,
+                    cursor->values[segment].data());
+    cursor->decoded[segment] = true;
+  }
+}
+
+// Moves to the next block in which some row satisfies the constraints.
+void columnar_fill(ColumnarCursor *cursor) {
+  auto *table = (ColumnarTable *)cursor->base.pVtab;
+  size_t n_blocks = table->segments[0]->blocks.size();
+  cursor->pos = 0;
+
+  while (cursor->next_block < n_blocks) {
+    size_t block = cursor->next_block++;
+    bool skip = false;
+    for (const ColumnarConstraint &constraint : cursor->constraints) {
+      bool integer = constraint.column < 0 ||
+                     table->columns.integer[constraint.column];
+      skip = skip || !columnar_may_match(
+                         constraint,
+                         table->segments[constraint.column + 1]->blocks[block],
+                         integer);
+    }
+    if (skip) {
+      continue;
+    }
+
+    cursor->block = block;
+    size_t n =
+        std::min<uint64_t>(batch_size, table->n_rows - block * batch_size);
+    for (size_t i = 0; i < n; ++i) {
+      cursor->selection[i] = (uint16_t)i;
+    }
+    cursor->selected = n;
+    std::fill(cursor->decoded.begin(), cursor->decoded.end(), false);
+
+    for (const ColumnarConstraint &constraint : cursor->constraints) {
+      if (cursor->selected == 0) {
+        break;
+      }
+      int segment = constraint.column + 1;
+      columnar_decode_segment(cursor, segment);
+      const sqlite3_int64 *values = cursor->values[segment].data();
+      if (constraint.column < 0 || table->columns.integer[constraint.column]) {
+        cursor->selected = batch_select(
+            constraint.op, constraint.int_value,
+            [values](uint16_t i) { return values[i]; },
+            cursor->selection.data(), cursor->selected);
+      } else {
+        const uint8_t *match = constraint.match.data();
+        cursor->selected = batch_select(
+            SQLITE_INDEX_CONSTRAINT_EQ, (uint8_t)1,
+            [values, match](uint16_t i) { return match[values[i]]; },
+            cursor->selection.data(), cursor->selected);
+      }
+    }
+
+    if (cursor->selected > 0) {
+      for (int segment : cursor->used) {
+        columnar_decode_segment(cursor, segment);
+      }
+      cursor->eof = false;
+      return;
+    }
+  }
+  cursor->eof = true;
+}
+
+int columnar_filter(sqlite3_vtab_cursor *cur, int, const char *idx_str,
+                    int argc, sqlite3_value **argv) {
+  auto *cursor = (ColumnarCursor *)cur;
+  auto *table = (ColumnarTable *)cur->pVtab;
+
+  std::istringstream plan(idx_str);
+  sqlite3_uint64 col_used;
+  plan >> col_used;
+
+  cursor->constraints.clear();
+  for (int i = 0; i < argc; ++i) {
+    ColumnarConstraint constraint;
+    int op;
+    plan >> constraint.column >> op;
+    constraint.op = (unsigned char)op;
+    if (constraint.column < 0 || table->columns.integer[constraint.column]) {
+      constraint.int_value = sqlite3_value_int64(argv[i]);
+    } else {
+      // Evaluates the constraint once per distinct value.
+      std::string rhs((const char *)sqlite3_value_text(argv[i]),
+                      (size_t)sqlite3_value_bytes(argv[i]));
+      const std::vector<std::string> &dictionary =
+          table->segments[constraint.column + 1]->dictionary;
+      constraint.matches_below.push_back(0);
+      for (const std::string &value : dictionary) {
+        constraint.match.push_back(
+            vtab_satisfies(constraint.op, value.compare(rhs)));
+        constraint.matches_below.push_back(constraint.matches_below.back() +
+                                           constraint.match.back());
+      }
+    }
+    cursor->constraints.push_back(std::move(constraint));
+  }
+
+  cursor->used.clear();
+  for (size_t column = 0; column < table->columns.names.size(); ++column) {
+    bool used = col_used & ((sqlite3_uint64)1 << std::min<size_t>(column, 63));
+    for (const ColumnarConstraint &constraint : cursor->constraints) {
+      used = used && constraint.column != (int)column;
+    }
+    if (used) {
+      cursor->used.push_back((int)column + 1);
+    }
+  }
+
+  cursor->next_block = 0;
+  columnar_fill(cursor);
+  return SQLITE_OK;
+}
+
+int columnar_next(sqlite3_vtab_cursor *cur) {
+  auto *cursor = (ColumnarCursor *)cur;
+  if (++cursor->pos >= cursor->selected) {
+    columnar_fill(cursor);
+  }
+  return SQLITE_OK;
+}
+
+int columnar_eof(sqlite3_vtab_cursor *cur) {
+  return ((ColumnarCursor *)cur)->eof;
+}
+
+int columnar_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i) {
+  auto *cursor = (ColumnarCursor *)cur;
+  auto *table = (ColumnarTable *)cur->pVtab;
+  if (!cursor->decoded[i + 1]) {
+    // Not used: SQLite only asks for columns outside colUsed when it needs a
+    // placeholder value.
+    sqlite3_result_null(ctx);
+    return SQLITE_OK;
+  }
+  sqlite3_int64 value =
+      cursor->values[i + 1][cursor->selection[cursor->pos]];
+  if (table->columns.integer[i]) {
+    sqlite3_result_int64(ctx, value);
+  } else {
+    const std::string &text = table->segments[i + 1]->dictionary[value];
+    sqlite3_result_text(ctx, text.data(), (int)text.size(), SQLITE_STATIC);
+  }
+  return SQLITE_OK;
+}
+
+// The rowids are only decoded if they are asked for.
+int columnar_rowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid) {
+  auto *cursor = (ColumnarCursor *)cur;
+  columnar_decode_segment(cursor, 0);
+  *rowid = cursor->values[0][cursor->selection[cursor->pos]];
+  return SQLITE_OK;
+}
+
+sqlite3_module columnar_module = {
+    0,                   // iVersion
+    columnar_connect,    // xCreate
+    columnar_connect,    // xConnect
+    columnar_best_index, // xBestIndex
+    columnar_disconnect, // xDisconnect
+    columnar_disconnect, // xDestroy
+    columnar_open,       // xOpen
+    columnar_close,      // xClose
+    columnar_filter,     // xFilter
+    columnar_next,       // xNext
+    columnar_eof,        // xEof
+    columnar_column,     // xColumn
+    columnar_rowid,      // xRowid
+    nullptr,             // xUpdate
+    nullptr,             // xBegin
+    nullptr,             // xSync
+    nullptr,             // xCommit
+    nullptr,             // xRollback
+    nullptr,             // xFindFunction
+    nullptr,             // xRename
+    nullptr,             // xSavepoint
+    nullptr,             // xRelease
+    nullptr,             // xRollbackTo
+    nullptr,             // xShadowName
+};
+
+int create_columnar_module(sqlite3 *db) {
+  return sqlite3_create_module(db, "columnar", &columnar_module, nullptr);
+}
+
+#endif // SQLITE_PERFORMANCE_SSB_COLUMNAR_HPP
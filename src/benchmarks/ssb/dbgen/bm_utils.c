@@ -110,7 +110,6 @@ static char alpha_num[65] =
 
 void usage();
 long *permute_dist(distribution *d, long stream);
-extern long Seed[];
 
 /*
  * env_config: look for a environmental variable setting and return its
@@ -177,8 +177,8 @@ void
 hd_sparse(long i, DSS_HUGE *ok, long seq)
 	{
 	DSS_HUGE low_mask, seq_mask;
-	static int init = 0;
-	static DSS_HUGE *base, *res;
+	static THREAD_LOCAL int init = 0;
+	static THREAD_LOCAL DSS_HUGE *base, *res;
 	
 	if (init == 0)
 		{
@@ -215,7 +215,7 @@ mk_order(long index, order_t *o, long upd_num)
 	long      c_date;
 	long      clk_num;
 	/* long      supp_num; */
-	static char **asc_date = NULL;
+	static THREAD_LOCAL char **asc_date = NULL;
 	/* char tmp_str[2]; */
 	char **mk_ascdate PROTO((void));
 	int delta = 1;
@@ -300,7 +300,7 @@ mk_order(long index, order_t *o, long upd_num)
 	long      c_date;
 	long      clk_num;
 	long      supp_num;
-	static char **asc_date = NULL;
+	static THREAD_LOCAL char **asc_date = NULL;
 	char tmp_str[2];
 	char **mk_ascdate PROTO((void));
 	int delta = 1;
@@ -393,8 +393,8 @@ mk_order(long index, order_t *o, long upd_num)
         o->orderstatus = 'P';
     if (ocnt == o->lines)
         o->orderstatus = 'F';
-	
-	return (0);
+
+    return (0);
 }
 #endif
 
@@ -688,8 +688,15 @@ mk_date(long index,date_t *d)
     long espan = (index-1)*60*60*24;
     
     time_t numDateTime = D_STARTDATE + espan; 
+    struct tm localTimeBuf;
 
-    struct tm *localTime = localtime(&numDateTime); 
+    /* pload() may call this on several threads at once */
+#ifdef _MSC_VER
+    struct tm *localTime = &localTimeBuf;
+    localtime_s(localTime, &numDateTime);
+#else
+    struct tm *localTime = localtime_r(&numDateTime, &localTimeBuf);
+#endif
  
     /*make Sunday be the first day of a week */
     d->daynuminweek=((long)localTime->tm_wday+1)%7+1;
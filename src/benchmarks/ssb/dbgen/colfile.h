@@ -0,0 +1,33 @@
+/*
+ * colfile.h
+ *
+ * The binary column files that dbgen -D writes (load_binary.c) and the
+ * loaders of ssb_sqlite3 and ssb_duckdb map. Column i of a table is the file
+ * <table>.<i>.col: a header, then the value of every row in table order.
+ * Integers are 8 bytes, strings a 4-byte length followed by the bytes, with
+ * no terminator. Everything is in the byte order of the machine that
+ * generated the data.
+ */
+
+#ifndef COLFILE_H
+#define COLFILE_H
+
+#include <stdint.h>
+
+#define COLFILE_MAGIC	"SSBCOL1"	/* with its terminator, 8 bytes */
+#define COLFILE_SUFFIX	".col"
+
+#define COLFILE_INT		1
+#define COLFILE_STR		2
+
+typedef struct
+{
+	char		magic[8];
+	uint64_t	rows;
+	uint32_t	n_columns;		/* of the table */
+	uint32_t	column;			/* the index of this column */
+	uint32_t	type;			/* COLFILE_INT or COLFILE_STR */
+	uint32_t	reserved;
+} colfile_header_t;
+
+#endif /* COLFILE_H */
@@ -6,9 +6,9 @@
 #define NO_LFUNC (long (*) ()) NULL		/* to clean up tdefs */
 
 #include "config.h"
-#if (defined(HAVE_FORK) && defined(HAVE_WAIT) && defined(HAVE_KILL))
+#ifdef HAVE_PTHREAD_H
 #define CAN_PARALLELIZE_DATA_GENERATION
-#endif /* (defined(HAVE_FORK) && defined(HAVE_WAIT) && defined(HAVE_KILL)) */
+#endif /* HAVE_PTHREAD_H */
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -18,6 +18,7 @@
 #include <signal.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
@@ -41,9 +42,9 @@ int     getopt(int arg_cnt, char **arg_vect, char *options);
 #include <unistd.h>
 #endif
 
-#ifdef HAVE_SYS_WAIT_H
-#include <sys/wait.h>
-#endif
+#ifdef CAN_PARALLELIZE_DATA_GENERATION
+#include <pthread.h>
+#endif /* CAN_PARALLELIZE_DATA_GENERATION */
 
 #if (defined(HAVE_PROCESS_H) && defined(HAVE_WINDOWS_H)) // Windows system
 /* TODO: Do we really need all of these Windows-specific definitions? */
@@ -88,9 +89,9 @@ int     getopt(int arg_cnt, char **arg_vect, char *options);
 void	usage (void);
 int		prep_direct (char *);
 int		close_direct (void);
-void	kill_load (void);
 int		pload (int tbl);
 void	gen_tbl (int tnum, DSS_HUGE start, DSS_HUGE count, long upd_num);
+DSS_HUGE	table_rows (int tnum);
 int		pr_drange (int tbl, DSS_HUGE min, DSS_HUGE cnt, long num);
 int		set_files (int t, int pload);
 int		partial (int, int);
@@ -100,6 +101,8 @@ extern int optind, opterr;
 extern char *optarg;
 DSS_HUGE rowcnt = 0, minrow = 0;
 long upd_num = 0;
+/* the rows gen_tbl() built on this thread; a lineorder counts each line */
+THREAD_LOCAL DSS_HUGE rows_done = 0;
 double flt_scale;
 #if ( defined(WIN32) && !defined(_POSIX_C_SOURCE) )
 char *spawn_args[25];
@@ -182,6 +185,7 @@ int ld_region (code_t * c, int mode);
 long sd_cust (int child, long skip_count);
 long sd_part (int child, long skip_count);
 long sd_supp (int child, long skip_count);
+long sd_date (int child, long skip_count);
 
 long sd_line (int child, long skip_count);
 long sd_order (int child, long skip_count);
@@ -255,7 +259,7 @@ tdef tdefs[] =
     
 	{"customer.tbl", "customers table", 30000, hd_cust,
 		{pr_cust, ld_cust}, sd_cust, vrf_cust, NONE, 0},
-	{"date.tbl","date table",2557,0,{pr_date,ld_date}, NULL,vrf_date, NONE,0},
+	{"date.tbl","date table",2557,0,{pr_date,ld_date}, sd_date,vrf_date, NONE,0},
 	/*line order is SF*1,500,000, however due to the implementation
 	  the base here is 150,000 instead if 1500,000*/
 	{"lineorder.tbl", "lineorder table", 150000, hd_line,
@@ -291,42 +295,6 @@ tdef tdefs[] =
 	{"region.tbl", "region table", NATIONS_MAX, hd_region,
 		{pr_region, ld_region}, NO_LFUNC, vrf_region, NONE, 0},
 };
-#endif
-int *pids;
-
-
-/*
-* routines to handle the graceful cleanup of multi-process loads
-*/
-
-void
-stop_proc (int signum)
-{
-	UNUSED(signum);
-	exit (0);
-}
-
-/*
- * Notes:
- * The parallell load code is at best brittle, and seems not to 
- * have been tested or even built on non-Linux platforms.
- */
-
-#ifdef HAVE_KILL
-
-void
-kill_load (void)
-{
-	int i;
-	
-	for (i = 0; i < children; i++) 
-	{
-		if (pids[i])
-			kill(SIGUSR1, pids[i]);
-	}
-	return;
-}
-
 #endif
 
 /*
@@ -412,7 +380,7 @@ load_dists (void)
 void
 gen_tbl (int tnum, DSS_HUGE start, DSS_HUGE count, long upd_num)
 {
-	static order_t o;
+	static THREAD_LOCAL order_t o;
 	supplier_t supp;
 	customer_t cust;
 	part_t part;
@@ -421,8 +389,8 @@ gen_tbl (int tnum, DSS_HUGE start, DSS_HUGE count, long upd_num)
 #else
 	code_t code;
 #endif
-	static int completed = 0;
-	static int init = 0;
+	static THREAD_LOCAL int completed = 0;
+	static THREAD_LOCAL int init = 0;
 	DSS_HUGE i;
 
 	int rows_per_segment=0;
@@ -541,22 +509,31 @@ gen_tbl (int tnum, DSS_HUGE start, DSS_HUGE count, long upd_num)
 		case NATION:
 			mk_nation (i, &code);
 			if (set_seeds == 0)
+				{
 				if (validate)
 					tdefs[tnum].verify(&code, 0);
 				else
 					tdefs[tnum].loader[direct] (&code, 0);
+				}
 			break;
 		case REGION:
 			mk_region (i, &code);
 			if (set_seeds == 0)
+				{
 				if (validate)
 					tdefs[tnum].verify(&code, 0);
 				else
 					tdefs[tnum].loader[direct] (&code, 0);
+				}
 			break;
 #endif
 		}
 		row_stop(tnum);
+#ifdef SSB
+		rows_done += (tnum == LINE) ? o.lines : 1;
+#else
+		rows_done++;
+#endif
 		if (set_seeds && (i % tdefs[tnum].base) < 2)
 		{
 			printf("\nSeeds for %s at rowcount " HUGE_FORMAT "\n", tdefs[tnum].comment, i);
@@ -566,6 +543,44 @@ gen_tbl (int tnum, DSS_HUGE start, DSS_HUGE count, long upd_num)
 	completed |= 1 << tnum;
 }
 
+/*
+* wall clock seconds, for the rows/sec of a table
+*/
+static double
+wall_time (void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+#else
+	return ((double)time(NULL));
+#endif
+}
+
+/*
+* the number of rows of a table at the scale of the run
+*/
+DSS_HUGE
+table_rows (int tnum)
+{
+	DSS_HUGE rows;
+
+	if (tnum < NATION)
+		rows = tdefs[tnum].base * scale;
+	else
+		rows = tdefs[tnum].base;
+#ifdef SSB
+	if (tnum == PART)
+		rows = (DSS_HUGE) (tdefs[tnum].base * (floor(1+log((double)(scale))/(log(2)))));
+	if (tnum == DATE)
+		rows = tdefs[tnum].base;
+#endif
+
+	return (rows);
+}
+
 
 
 void
@@ -589,8 +604,10 @@ usage (void)
 #endif
 	fprintf (stderr, "-b <s> -- load distributions from file <s> (default: " DIST_DFLT ")\n");
 	fprintf (stderr, "-C <n> -- separate data set into <n> chunks\n");
-	fprintf (stderr, "          (requires -S; default: 1; uses <n> child processes)\n");
+	fprintf (stderr, "          (default: 1; with -S, build one chunk; without,\n");
+	fprintf (stderr, "          build all of them on <n> threads into the usual files)\n");
 	fprintf (stderr, "-D     -- do database load in line\n");
+	fprintf (stderr, "          (dbgen: write binary column files <table>.<n>.col)\n");
 	fprintf (stderr, "-d <n> -- split deletes between <n> files\n");
 	fprintf (stderr, "-f     -- force. Overwrite existing files\n");
 	fprintf (stderr, "-F     -- generate flat files output\n");
@@ -671,74 +688,208 @@ partial (int tbl, int s)
 	return (0);
 }
 
+#ifdef CAN_PARALLELIZE_DATA_GENERATION
 /*
- * Notes:
- * This code is at best brittle, and seems not to have been tested or
- * even built on non-Linux platforms.
+ * pload() generates a table on <children> threads. The rows are cut into
+ * chunks of PLOAD_CHUNK. A thread takes the next chunk, moves its own copy
+ * of the RNG streams to the first row of the chunk with the skip-ahead of
+ * speed_seed.c and prints the chunk into a buffer. The buffers are written
+ * to the table's file in chunk order, so the file is the one the serial run
+ * writes. The threads get at most PLOAD_WINDOW chunks each ahead of the
+ * writer.
  */
+#define PLOAD_CHUNK		10000
+#define PLOAD_WINDOW	2
+
+extern THREAD_LOCAL FILE *print_target[];
+
+typedef struct
+{
+	int			tbl;
+	int			n_out;			/* the table, and its child if any */
+	int			out[2];
+	DSS_HUGE	rows;
+	DSS_HUGE	chunks;
+	DSS_HUGE	window;
+	seed_t		*seeds;			/* the streams at the first row */
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	DSS_HUGE	next;			/* the next chunk to generate */
+	DSS_HUGE	written;		/* the chunks written so far */
+	DSS_HUGE	rows_done;		/* the rows of the threads that are done */
+	int			*done;			/* chunk i is in slot i % window */
+	char		**text[2];
+	size_t		*size[2];
+} pload_t;
+
+/*
+* move the streams of a table ahead by rows rows, as set_state() does
+*/
+static void
+skip_rows (int tbl, DSS_HUGE rows)
+{
+	if (tdefs[tbl].gen_seed == NULL)
+		return;
+	tdefs[tbl].gen_seed((tbl == LINE) ? 1 : 0, (long)rows);
+	if (tdefs[tbl].child != NONE)
+		tdefs[tdefs[tbl].child].gen_seed(0, (long)rows);
+}
+
+static void *
+pload_thread (void *arg)
+{
+	pload_t *p = (pload_t *)arg;
+	FILE *f[2];
+	char *buf[2];
+	size_t len[2];
+	char *text;
+	DSS_HUGE chunk, start;
+	int t;
+
+	/* print_prep() hands these to the print routines of the thread */
+	for (t = 0; t < p->n_out; t++)
+	{
+		f[t] = open_memstream(&buf[t], &len[t]);
+		OPEN_CHECK(f[t], tdefs[p->out[t]].name);
+		print_target[p->out[t]] = f[t];
+	}
+
+	for (;;)
+	{
+		pthread_mutex_lock(&p->lock);
+		while (p->next < p->chunks && p->next >= p->written + p->window)
+			pthread_cond_wait(&p->changed, &p->lock);
+		chunk = p->next++;
+		pthread_mutex_unlock(&p->lock);
+		if (chunk >= p->chunks)
+			break;
+
+		start = chunk * PLOAD_CHUNK;
+		memcpy(Seed, p->seeds, sizeof(seed_t) * (MAX_STREAM + 1));
+		skip_rows(p->tbl, start);
+		for (t = 0; t < p->n_out; t++)
+			fseek(f[t], 0L, SEEK_SET);
+		gen_tbl(p->tbl, start + 1, MIN(PLOAD_CHUNK, p->rows - start), upd_num);
+
+		for (t = 0; t < p->n_out; t++)
+		{
+			fflush(f[t]);
+			text = (char *)malloc(len[t] + 1);
+			MALLOC_CHECK(text);
+			memcpy(text, buf[t], len[t]);
+			p->text[t][chunk % p->window] = text;
+			p->size[t][chunk % p->window] = len[t];
+		}
+		pthread_mutex_lock(&p->lock);
+		p->done[chunk % p->window] = 1;
+		pthread_cond_broadcast(&p->changed);
+		pthread_mutex_unlock(&p->lock);
+	}
+
+	pthread_mutex_lock(&p->lock);
+	p->rows_done += rows_done;
+	pthread_mutex_unlock(&p->lock);
+	for (t = 0; t < p->n_out; t++)
+	{
+		print_target[p->out[t]] = NULL;
+		fclose(f[t]);
+		free(buf[t]);
+	}
+	return (NULL);
+}
 
-#ifdef CAN_PARALLELIZE_DATA_GENERATION
 int
 pload (int tbl)
 {
-	int c = 0, i, status;
-	
+	pload_t p;
+	pthread_t *threads;
+	FILE *out[2];
+	long c, verbosity = verbose;
+	DSS_HUGE chunk, slot;
+	int t;
+
 	if (verbose > 0)
 	{
-		fprintf (stderr, "Starting %ld children to load %s",
+		fprintf (stderr, "Starting %ld threads to generate %s...",
 			children, tdefs[tbl].comment);
 	}
-	for (c = 0; c < children; c++)
+
+	p.tbl = tbl;
+	p.n_out = 0;
+	p.out[p.n_out++] = tbl;
+	if (tdefs[tbl].child != NONE)
+		p.out[p.n_out++] = tdefs[tbl].child;
+	p.rows = table_rows(tbl);
+	p.chunks = (p.rows + PLOAD_CHUNK - 1) / PLOAD_CHUNK;
+	p.window = PLOAD_WINDOW * children;
+	p.seeds = Seed;
+	pthread_mutex_init(&p.lock, NULL);
+	pthread_cond_init(&p.changed, NULL);
+	p.next = 0;
+	p.written = 0;
+	p.rows_done = 0;
+	p.done = (int *)calloc(p.window, sizeof(int));
+	MALLOC_CHECK(p.done);
+	for (t = 0; t < p.n_out; t++)
 	{
-		pids[c] = fork();
-		if (pids[c] == -1)
+		p.text[t] = (char **)malloc(p.window * sizeof(char *));
+		MALLOC_CHECK(p.text[t]);
+		p.size[t] = (size_t *)malloc(p.window * sizeof(size_t));
+		MALLOC_CHECK(p.size[t]);
+		out[t] = tbl_open(p.out[t], "w");
+		OPEN_CHECK(out[t], tdefs[p.out[t]].name);
+	}
+	threads = (pthread_t *)malloc(children * sizeof(pthread_t));
+	MALLOC_CHECK(threads);
+
+	verbose = 0;
+	for (c = 0; c < children; c++)
+		if (pthread_create(&threads[c], NULL, pload_thread, &p) != 0)
 		{
-			perror ("Child loader not created");
-			kill_load();
+			perror ("Generation thread not created");
 			exit (-1);
 		}
-		else if (pids[c] == 0)	/* CHILD */
-		{
-			signal(SIGUSR1, stop_proc);
-			verbose = 0;
-			partial (tbl, c+1);
-			exit (0);
-		}
-		else if (verbose > 0)			/* PARENT */
+
+	for (chunk = 0; chunk < p.chunks; chunk++)
+	{
+		slot = chunk % p.window;
+		pthread_mutex_lock(&p.lock);
+		while (!p.done[slot])
+			pthread_cond_wait(&p.changed, &p.lock);
+		pthread_mutex_unlock(&p.lock);
+
+		for (t = 0; t < p.n_out; t++)
 		{
-			fprintf (stderr, ".");
+			fwrite(p.text[t][slot], 1, p.size[t][slot], out[t]);
+			free(p.text[t][slot]);
 		}
+
+		pthread_mutex_lock(&p.lock);
+		p.done[slot] = 0;
+		p.written++;
+		pthread_cond_broadcast(&p.changed);
+		pthread_mutex_unlock(&p.lock);
 	}
-	
-	if (verbose > 0)
-		fprintf (stderr, "waiting...");
 
-	c = children;
-	while (c)
+	for (c = 0; c < children; c++)
+		pthread_join(threads[c], NULL);
+
+	/* leave the streams where the serial run leaves them, for the tables
+	 * that draw on them later */
+	skip_rows(tbl, p.rows);
+	verbose = verbosity;
+	rows_done += p.rows_done;
+
+	for (t = 0; t < p.n_out; t++)
 	{
-		i = wait(&status);
-		if (i == -1 && children)
-		{
-			if (errno == ECHILD)
-				fprintf (stderr, "\nCould not wait on pid %d\n", pids[c - 1]);
-			else if (errno == EINTR)
-				fprintf (stderr, "\nProcess %d stopped abnormally\n", pids[c - 1]);
-			else if (errno == EINVAL)
-				fprintf (stderr, "\nProgram bug\n");
-		}
-		if (! WIFEXITED(status)) {
-			(void) fprintf(stderr, "\nProcess %d: ", i);
-			if (WIFSIGNALED(status)) {
-				(void) fprintf(stderr, "rcvd signal %d\n",
-					WTERMSIG(status));
-				} else if (WIFSTOPPED(status)) {
-				(void) fprintf(stderr, "stopped, signal %d\n",
-					WSTOPSIG(status));
-					}
-				
-			}
-		c--;
+		fclose(out[t]);
+		free(p.text[t]);
+		free(p.size[t]);
 	}
+	free(p.done);
+	free(threads);
+	pthread_cond_destroy(&p.changed);
+	pthread_mutex_destroy(&p.lock);
 
 	if (verbose > 0)
 		fprintf (stderr, "done\n");
@@ -942,10 +1093,10 @@ process_options (int count, char **vector)
 	  }
 
 #ifndef DOS
-	if (children != 1 && step == -1)
+	if (children != 1 && step == -1 && direct)
 		{
-		pids = malloc(children * sizeof(pid_t));
-		MALLOC_CHECK(pids)
+		fprintf(stderr, "ERROR: -C without -S generates flat files only\n");
+		exit(1);
 		}
 #else
 	if (children != 1 && step < 0)
@@ -966,6 +1117,7 @@ process_options (int count, char **vector)
 int main(int ac, char **av)
 {
 	int i;
+	double seconds;
 
 	table = 
 #ifdef SSB
@@ -1130,6 +1282,8 @@ int main(int ac, char **av)
 	for (i = PART; i <= REGION; i++)
 		if (table & (1 << i))
 		{
+			rows_done = 0;
+			seconds = wall_time();
 			if (children > 1 && i < NATION)
 			{
 				if (step >= 0)
@@ -1163,18 +1317,7 @@ int main(int ac, char **av)
 			else
 			{
 				minrow = 1;
-				if (i < NATION)
-					rowcnt = tdefs[i].base * scale;
-				else
-					rowcnt = tdefs[i].base;
-#ifdef SSB
-				if(i==PART){
-					rowcnt = (DSS_HUGE) (tdefs[i].base * (floor(1+log((double)(scale))/(log(2)))));
-				}
-				if(i==DATE){
-					rowcnt = tdefs[i].base;
-				}
-#endif
+				rowcnt = table_rows (i);
 				if (verbose > 0)
 					fprintf (stderr, "%s data for %s [pid: %d]: ",
 					(validate)?"Validating":"Generating", tdefs[i].comment, DSS_PROC);
@@ -1182,6 +1325,16 @@ int main(int ac, char **av)
 				if (verbose > 0)
 					fprintf (stderr, "done.\n");
 			}
+			seconds = wall_time() - seconds;
+			if (verbose >= 0)
+			{
+				fprintf (stderr, "%s: " HUGE_FORMAT " rows in %.2f s",
+					tdefs[i].comment, rows_done, seconds);
+				if (seconds > 0)
+					fprintf (stderr, " (%.0f rows/sec)",
+						rows_done / seconds);
+				fprintf (stderr, "\n");
+			}
 			if (validate)
 				printf("Validation checksum for %s at %ld GB: %0lx\n",
 					 tdefs[i].name, scale, tdefs[i].vtotal);
@@ -176,6 +176,20 @@ typedef struct SEED_T {
 	long boundary;
 	} seed_t;
 
+/*
+ * the RNG streams, and the few statics that generating a row touches, are
+ * per thread, so that pload() can generate the chunks of a table on
+ * threads of their own
+ */
+#ifndef THREAD_LOCAL
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+#endif
+extern THREAD_LOCAL seed_t Seed[];
+
 
 #if defined(__STDC__)
 #define PROTO(s) s
@@ -509,6 +523,7 @@ extern tdef tdefs[];
 #define DT_CHR		6
 
 int dbg_print(int dt, FILE *tgt, void *data, int len, int eol);
+int dbg_end(FILE *tgt);
 #define PR_STR(f, str, len)		dbg_print(DT_STR, f, (void *)str, len, 1)
 #define PR_VSTR(f, str, len) 	dbg_print(DT_VSTR, f, (void *)str, len, 1)
 #define PR_VSTR_LAST(f, str, len) 	dbg_print(DT_VSTR, f, (void *)str, len, 0)
@@ -518,7 +533,7 @@ int dbg_print(int dt, FILE *tgt, void *data, int len, int eol);
 #define PR_MONEY(f, val) 		{ long tmp = val; dbg_print(DT_MONEY, f, &tmp, 0, 1);  }
 #define PR_CHR(f, val)	 		{ char tmp = val; dbg_print(DT_CHR,   f, &tmp, 0, 1);  }
 #define  PR_STRT(fp)   /* any line prep for a record goes here */
-#define  PR_END(fp)    fprintf(fp, "\n")   /* finish the record here */
+#define  PR_END(fp)    dbg_end(fp)   /* finish the record here */
 
 
 #ifdef SSB
@@ -542,7 +557,7 @@ int dbg_print(int dt, FILE *tgt, void *data, int len, int eol);
 	int yr_  = yr; \
 	int mn_  = mn; \
 	int dy_  = dy; \
-	snprintf(tgt, 2+1+2+1+4+1, "%02d-%02d-19%02d", yr_, mn_, dy_) \
+	snprintf(tgt, 4+1+2+1+2+1, "19%02d-%02d-%02d", yr_, mn_, dy_); \
 }
 #endif
 
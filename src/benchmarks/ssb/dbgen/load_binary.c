@@ -0,0 +1,179 @@
+/*
+ * load_binary.c
+ *
+ * The target of load_target.h for dbgen itself: every table is written as
+ * a set of binary column files (colfile.h) in the directory of the .tbl
+ * files, which the loaders of ssb_sqlite3 and ssb_duckdb map and bind
+ * without parsing. The type of a column is the one of its first value.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "dss.h"
+#include "colfile.h"
+#include "load_target.h"
+
+#define MAX_COLUMNS		32
+#define COLUMN_BUF_SIZE	(1 << 18)	/* stdio buffer of a column file */
+
+static const char *table_name = NULL;
+static int n_columns = 0;
+static int column = 0;
+static uint64_t rows = 0;
+static struct
+{
+    FILE *f;
+    char *path;
+    uint32_t type;
+} columns[MAX_COLUMNS];
+
+static void
+write_check(const void *data, size_t size, int i)
+{
+    if (fwrite(data, 1, size, columns[i].f) != size)
+        {
+        fprintf(stderr, "Cannot write %s\n", columns[i].path);
+        exit(1);
+        }
+}
+
+static void
+write_header(int i)
+{
+    colfile_header_t header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COLFILE_MAGIC, sizeof(header.magic));
+    header.rows = rows;
+    header.n_columns = (uint32_t)n_columns;
+    header.column = (uint32_t)i;
+    header.type = columns[i].type;
+    write_check(&header, sizeof(header), i);
+}
+
+/* writes the row count and the types into the headers and closes the files
+ * of the current table */
+static void
+close_table(void)
+{
+    int i;
+
+    for (i = 0; i < n_columns; i++)
+        {
+        if (fseek(columns[i].f, 0L, SEEK_SET) != 0)
+            {
+            fprintf(stderr, "Cannot seek in %s\n", columns[i].path);
+            exit(1);
+            }
+        write_header(i);
+        if (fclose(columns[i].f) != 0)
+            {
+            fprintf(stderr, "Cannot write %s\n", columns[i].path);
+            exit(1);
+            }
+        free(columns[i].path);
+        }
+    n_columns = 0;
+    table_name = NULL;
+}
+
+static void
+set_type(uint32_t type)
+{
+    if (column >= n_columns)
+        {
+        fprintf(stderr, "Too many values in a row of %s\n", table_name);
+        exit(1);
+        }
+    if (columns[column].type == 0)
+        columns[column].type = type;
+    else if (columns[column].type != type)
+        {
+        fprintf(stderr, "Column %d of %s changes type\n", column, table_name);
+        exit(1);
+        }
+}
+
+void
+target_open(const char *name)
+{
+    /* the files go where the .tbl files would */
+    UNUSED(name);
+}
+
+void
+target_table(const char *table, int n)
+{
+    const char *dir;
+    int i;
+
+    /* the loaders pass the same literal for every row of a table, and the
+     * tables are generated one after the other */
+    if (table == table_name)
+        return;
+    if (table_name != NULL)
+        close_table();
+
+    if (n > MAX_COLUMNS)
+        {
+        fprintf(stderr, "Too many columns in %s\n", table);
+        exit(1);
+        }
+    dir = env_config(PATH_TAG, PATH_DFLT);
+    table_name = table;
+    n_columns = n;
+    rows = 0;
+    for (i = 0; i < n; i++)
+        {
+        columns[i].path = (char *)malloc(strlen(dir) + strlen(table) + 32);
+        MALLOC_CHECK(columns[i].path);
+        sprintf(columns[i].path, "%s%c%s.%d" COLFILE_SUFFIX, dir, PATH_SEP,
+            table, i);
+        columns[i].f = fopen(columns[i].path, "wb");
+        OPEN_CHECK(columns[i].f, columns[i].path);
+        setvbuf(columns[i].f, NULL, _IOFBF, COLUMN_BUF_SIZE);
+        columns[i].type = 0;
+        /* rewritten by close_table() */
+        write_header(i);
+        }
+}
+
+void
+target_int(long value)
+{
+    int64_t v = (int64_t)value;
+
+    set_type(COLFILE_INT);
+    write_check(&v, sizeof(v), column++);
+}
+
+void
+target_str(const char *value)
+{
+    uint32_t len = (uint32_t)strlen(value);
+
+    set_type(COLFILE_STR);
+    write_check(&len, sizeof(len), column);
+    write_check(value, len, column++);
+}
+
+void
+target_end_row(void)
+{
+    if (column != n_columns)
+        {
+        fprintf(stderr, "Too few values in a row of %s\n", table_name);
+        exit(1);
+        }
+    column = 0;
+    rows++;
+}
+
+void
+target_close(void)
+{
+    if (table_name != NULL)
+        close_table();
+}
@@ -0,0 +1,139 @@
+/*
+ * load_duckdb.c
+ *
+ * The DuckDB target of load_target.h: every row goes to the appender of its
+ * table, which casts the values to the column types as COPY does for the
+ * fields of the .tbl files. An appender commits each chunk of rows it
+ * flushes, so a table never sits in a transaction as a whole.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "duckdb.h"
+#include "load_target.h"
+
+#define MAX_TABLES 8
+
+static duckdb_database db;
+static duckdb_connection conn;
+static struct
+{
+    const char *name;
+    duckdb_appender appender;
+} tables[MAX_TABLES];
+static int n_tables = 0;
+static duckdb_appender appender = NULL;
+static const char *table_name = NULL;
+
+static void
+check(duckdb_state state)
+{
+    if (state != DuckDBSuccess)
+        {
+        fprintf(stderr, "DuckDB load of %s failed: %s\n", table_name,
+            duckdb_appender_error(appender));
+        exit(1);
+        }
+}
+
+static void
+execute(const char *sql)
+{
+    duckdb_result result;
+
+    if (duckdb_query(conn, sql, &result) != DuckDBSuccess)
+        {
+        fprintf(stderr, "DuckDB load failed: %s\n",
+            duckdb_result_error(&result));
+        exit(1);
+        }
+    duckdb_destroy_result(&result);
+}
+
+void
+target_open(const char *name)
+{
+    char *script;
+
+    if (duckdb_open(name, &db) != DuckDBSuccess ||
+        duckdb_connect(db, &conn) != DuckDBSuccess)
+        {
+        fprintf(stderr, "Cannot open %s\n", name);
+        exit(1);
+        }
+
+    script = target_script("sql/init/duckdb.sql");
+    execute(script);
+    free(script);
+}
+
+void
+target_table(const char *table, int n_columns)
+{
+    int i;
+
+    (void)n_columns;
+    /* the loaders pass the same literal for every row of a table */
+    if (table == table_name)
+        return;
+
+    table_name = table;
+    for (i = 0; i < n_tables; i++)
+        if (strcmp(tables[i].name, table) == 0)
+            {
+            appender = tables[i].appender;
+            return;
+            }
+
+    if (n_tables == MAX_TABLES)
+        {
+        fprintf(stderr, "Too many tables for the DuckDB load\n");
+        exit(1);
+        }
+    if (duckdb_appender_create(conn, NULL, table, &appender) != DuckDBSuccess)
+        {
+        fprintf(stderr, "Cannot append to %s\n", table);
+        exit(1);
+        }
+
+    tables[n_tables].name = table;
+    tables[n_tables].appender = appender;
+    n_tables++;
+}
+
+void
+target_int(long value)
+{
+    check(duckdb_append_int64(appender, (int64_t)value));
+}
+
+void
+target_str(const char *value)
+{
+    check(duckdb_append_varchar(appender, value));
+}
+
+void
+target_end_row(void)
+{
+    check(duckdb_appender_end_row(appender));
+}
+
+void
+target_close(void)
+{
+    int i;
+
+    for (i = 0; i < n_tables; i++)
+        {
+        table_name = tables[i].name;
+        appender = tables[i].appender;
+        check(duckdb_appender_close(appender));
+        duckdb_appender_destroy(&tables[i].appender);
+        }
+    n_tables = 0;
+    table_name = NULL;
+    duckdb_disconnect(&conn);
+    duckdb_close(&db);
+}
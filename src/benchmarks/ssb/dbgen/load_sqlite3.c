@@ -0,0 +1,146 @@
+/*
+ * load_sqlite3.c
+ *
+ * The SQLite target of load_target.h: every row is bound to a prepared INSERT
+ * of its table, all in one transaction. The values are the ones .import
+ * stores from the .tbl files, as the column affinity converts the text of an
+ * INTEGER column as it would for .import.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sqlite3.h"
+#include "load_target.h"
+
+#define MAX_TABLES 8
+
+static sqlite3 *db;
+static struct
+{
+    const char *name;
+    sqlite3_stmt *stmt;
+} tables[MAX_TABLES];
+static int n_tables = 0;
+static sqlite3_stmt *stmt = NULL;
+static const char *table_name = NULL;
+static int column = 0;
+
+static void
+check(int rc, int expected)
+{
+    if (rc != expected)
+        {
+        fprintf(stderr, "SQLite load of %s failed: %s\n",
+            table_name ? table_name : "the schema", sqlite3_errmsg(db));
+        exit(1);
+        }
+}
+
+static void
+execute(const char *sql)
+{
+    char *message = NULL;
+
+    if (sqlite3_exec(db, sql, NULL, NULL, &message) != SQLITE_OK)
+        {
+        fprintf(stderr, "SQLite load failed: %s\n", message);
+        exit(1);
+        }
+}
+
+void
+target_open(const char *name)
+{
+    char *script;
+
+    /* the library is built without automatic initialization */
+    if (sqlite3_initialize() != SQLITE_OK ||
+        sqlite3_open(name, &db) != SQLITE_OK)
+        {
+        fprintf(stderr, "Cannot open %s: %s\n", name, sqlite3_errmsg(db));
+        exit(1);
+        }
+
+    /* as for ssb_sqlite3 --load, a crash only loses a database that has to
+     * be loaded again anyway */
+    execute("PRAGMA journal_mode=OFF; PRAGMA synchronous=OFF");
+    script = target_script("sql/init/sqlite3.sql");
+    execute(script);
+    free(script);
+    execute("BEGIN");
+}
+
+void
+target_table(const char *table, int n_columns)
+{
+    char *sql;
+    int i;
+
+    /* the loaders pass the same literal for every row of a table */
+    if (table == table_name)
+        return;
+
+    table_name = table;
+    for (i = 0; i < n_tables; i++)
+        if (strcmp(tables[i].name, table) == 0)
+            {
+            stmt = tables[i].stmt;
+            return;
+            }
+
+    if (n_tables == MAX_TABLES)
+        {
+        fprintf(stderr, "Too many tables for the SQLite load\n");
+        exit(1);
+        }
+    sql = (char *)malloc(strlen(table) + 3 * n_columns + 40);
+    if (sql == NULL)
+        {
+        fprintf(stderr, "Malloc failed for the SQLite load\n");
+        exit(1);
+        }
+    sprintf(sql, "INSERT INTO main.\"%s\" VALUES (?", table);
+    for (i = 1; i < n_columns; i++)
+        strcat(sql, ", ?");
+    strcat(sql, ")");
+    check(sqlite3_prepare_v2(db, sql, -1, &stmt, NULL), SQLITE_OK);
+    free(sql);
+
+    tables[n_tables].name = table;
+    tables[n_tables].stmt = stmt;
+    n_tables++;
+}
+
+void
+target_int(long value)
+{
+    sqlite3_bind_int64(stmt, ++column, (sqlite3_int64)value);
+}
+
+void
+target_str(const char *value)
+{
+    sqlite3_bind_text(stmt, ++column, value, -1, SQLITE_STATIC);
+}
+
+void
+target_end_row(void)
+{
+    check(sqlite3_step(stmt), SQLITE_DONE);
+    sqlite3_reset(stmt);
+    column = 0;
+}
+
+void
+target_close(void)
+{
+    int i;
+
+    for (i = 0; i < n_tables; i++)
+        sqlite3_finalize(tables[i].stmt);
+    n_tables = 0;
+    table_name = NULL;
+    execute("COMMIT");
+    sqlite3_close(db);
+}
@@ -10,10 +10,186 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "config.h"
 #include "dss.h"
 #include "dsstypes.h"
 
+#ifdef LOAD_TARGET
+#include "load_target.h"
+
+/*
+ * inline load into the database of load_target.h: the rows go to the tables
+ * of sql/init/<target>.sql with the values that the .tbl files would hold
+ */
+
+char *
+target_script(const char *path)
+{
+    FILE *f;
+    char line[1024];
+    char *script;
+    size_t size = 0;
+
+    f = fopen(path, "r");
+    OPEN_CHECK(f, path);
+    script = (char *)malloc(1);
+    MALLOC_CHECK(script);
+    script[0] = '\0';
+    while (fgets(line, sizeof(line), f) != NULL)
+        {
+        if (line[0] == '.')
+            continue;
+        script = (char *)realloc(script, size + strlen(line) + 1);
+        MALLOC_CHECK(script);
+        strcpy(script + size, line);
+        size += strlen(line);
+        }
+    fclose(f);
+
+    return(script);
+}
+
+int 
+close_direct(void)
+{
+    target_close();
+    return(0);
+}
+
+int 
+prep_direct(char *name)
+{
+    target_open(name);
+    return(0);
+}
+
+int 
+ld_cust (customer_t *cp, int mode)
+{
+    UNUSED(mode);
+    target_table("customer", 8);
+    target_int(cp->custkey);
+    target_str(cp->name);
+    target_str(cp->address);
+    target_str(cp->city);
+    target_str(cp->nation_name);
+    target_str(cp->region_name);
+    target_str(cp->phone);
+    target_str(cp->mktsegment);
+    target_end_row();
+
+    return(0);
+}
+
+int 
+ld_part (part_t *pp, int mode)
+{
+    UNUSED(mode);
+    target_table("part", 9);
+    target_int(pp->partkey);
+    target_str(pp->name);
+    target_str(pp->mfgr);
+    target_str(pp->category);
+    target_str(pp->brand);
+    target_str(pp->color);
+    target_str(pp->type);
+    target_int(pp->size);
+    target_str(pp->container);
+    target_end_row();
+
+    return(0);
+}
+
+int 
+ld_supp (supplier_t *sp, int mode)
+{
+    UNUSED(mode);
+    target_table("supplier", 7);
+    target_int(sp->suppkey);
+    target_str(sp->name);
+    target_str(sp->address);
+    target_str(sp->city);
+    target_str(sp->nation_name);
+    target_str(sp->region_name);
+    target_str(sp->phone);
+    target_end_row();
+
+    return(0);
+}
+
+int 
+ld_line (order_t *p, int mode)
+{
+    long i;
+    lineorder_t *l;
+
+    UNUSED(mode);
+    target_table("lineorder", 17);
+    for (i = 0; i < p->lines; i++)
+        {
+        l = &p->lineorders[i];
+        target_int((long)*l->okey);
+        target_int(l->linenumber);
+        target_int(l->custkey);
+        target_int(l->partkey);
+        target_int(l->suppkey);
+        target_str(l->orderdate);
+        target_str(l->opriority);
+        target_int(l->ship_priority);
+        target_int(l->quantity);
+        target_int(l->extended_price);
+        target_int(l->order_totalprice);
+        target_int(l->discount);
+        target_int(l->revenue);
+        target_int(l->supp_cost);
+        target_int(l->tax);
+        target_str(l->commit_date);
+        target_str(l->shipmode);
+        target_end_row();
+        }
+
+    return(0);
+}
+
+int
+ld_date (date_t *d, int mode)
+{
+    char datekey[DATE_LEN];
+
+    UNUSED(mode);
+#if __GNUC__ >= 8
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#endif
+    PR_DATE(datekey, d->year-1900, d->monthnuminyear, d->daynuminmonth);
+#if __GNUC__ >= 8
+#pragma GCC diagnostic pop
+#endif
+    target_table("date", 17);
+    target_str(datekey);
+    target_str(d->date);
+    target_str(d->dayofweek);
+    target_str(d->month);
+    target_int(d->year);
+    target_int(d->yearmonthnum);
+    target_str(d->yearmonth);
+    target_int(d->daynuminweek);
+    target_int(d->daynuminmonth);
+    target_int(d->daynuminyear);
+    target_int(d->monthnuminyear);
+    target_int(d->weeknuminyear);
+    target_str(d->sellingseason);
+    target_str(d->lastdayinweekfl);
+    target_str(d->lastdayinmonthfl);
+    target_str(d->holidayfl);
+    target_str(d->weekdayfl);
+    target_end_row();
+
+    return(0);
+}
+#else
 int 
 close_direct(void)
 {
@@ -27,6 +203,7 @@ prep_direct(void)
     /* any preload prep goes here */
     return(0);
 }
+#endif /* LOAD_TARGET */
 
 int 
 hd_cust (FILE *f)
@@ -40,6 +217,7 @@ hd_cust (FILE *f)
     return(0);
 }
 
+#ifndef LOAD_TARGET
 int 
 ld_cust (customer_t *cp, int mode)
 {
@@ -54,6 +232,7 @@ ld_cust (customer_t *cp, int mode)
 
     return(0);
 }
+#endif /* !LOAD_TARGET */
 
 int 
 hd_part (FILE *f)
@@ -67,6 +246,7 @@ hd_part (FILE *f)
     return(0);
 }
 
+#ifndef LOAD_TARGET
 int 
 ld_part (part_t *pp, int mode)
 {
@@ -79,6 +259,7 @@ ld_part (part_t *pp, int mode)
 
     return(0);
 }
+#endif /* !LOAD_TARGET */
 
 int 
 ld_psupp (part_t *pp, int mode)
@@ -109,6 +290,7 @@ hd_supp (FILE *f)
     return(0);
 }
 
+#ifndef LOAD_TARGET
 int 
 ld_supp (supplier_t *sp, int mode)
 {
@@ -123,6 +305,7 @@ ld_supp (supplier_t *sp, int mode)
 
     return(0);
 }
+#endif /* !LOAD_TARGET */
 
 
 int 
@@ -152,6 +335,7 @@ ld_order (order_t *p, int mode)
     return(0);
 }
 
+#ifndef LOAD_TARGET
 int ld_line (order_t *p, int mode)
 {
     static int count = 0;
@@ -165,6 +349,7 @@ int ld_line (order_t *p, int mode)
 
     return(0);
 }
+#endif /* !LOAD_TARGET */
 
 
 
@@ -229,6 +414,7 @@ hd_region (FILE *f)
 {
     static int count = 0;
 
+    UNUSED(f);
     if (! count++)
         printf("No header has been defined for the region table\n");
 
@@ -240,6 +426,8 @@ ld_region (code_t *cp, int mode)
 {
     static int count = 0;
 
+    UNUSED(cp);
+    UNUSED(mode);
     if (! count++)
         printf("%s %s\n",
             "No load routine has been defined",
@@ -285,7 +473,7 @@ hd_part_psupp (FILE *f)
 }
 #endif
 
-#ifdef SSB
+#if defined(SSB) && !defined(LOAD_TARGET)
 int
 ld_date (date_t *d, int mode)
 {
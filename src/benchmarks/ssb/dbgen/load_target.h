@@ -0,0 +1,30 @@
+/*
+ * load_target.h
+ *
+ * The interface between the inline load routines of load_stub.c and a
+ * database (load_sqlite3.c, load_duckdb.c). With -D, dbgen hands every row to
+ * the target column by column instead of printing it to a .tbl file.
+ *
+ * A target reports errors on stderr and exits, as dbgen does for files.
+ */
+
+#ifndef LOAD_TARGET_H
+#define LOAD_TARGET_H
+
+/* creates the tables by running the init script of the target and opens a
+ * transaction */
+void target_open(const char *name);
+/* directs the following rows to the table, which has n_columns columns */
+void target_table(const char *table, int n_columns);
+void target_int(long value);
+/* value stays valid until target_end_row */
+void target_str(const char *value);
+void target_end_row(void);
+/* commits and closes the database */
+void target_close(void);
+
+/* the statements of the script at path, without the dot-commands of the
+ * sqlite3 shell; the caller frees the result */
+char *target_script(const char *path);
+
+#endif /* LOAD_TARGET_H */
@@ -61,7 +61,6 @@ long *permute(long *set, int cnt, long stream);
 long *permute_dist(distribution *d, long stream);
 long seed;
 char *eol[2] = {" ", "},"};
-extern seed_t Seed[];
 #ifdef TEST
 tdef tdefs = { NULL };
 #endif
@@ -75,8 +74,8 @@ long *
 permute(long *a, int c, long s)
 	{
     int i;
-    static long source;
-    static long *set, temp;
+    static THREAD_LOCAL long source;
+    static THREAD_LOCAL long *set, temp;
     
 	if (a != (long *)NULL)
 		{
@@ -104,20 +103,22 @@ permute(long *a, int c, long s)
 long *
 permute_dist(distribution *d, long stream)
 	{
-	static distribution *dist = NULL;
-	int i;
+	static THREAD_LOCAL distribution *dist = NULL;
+	/* permute() starts over from the identity on every new set, so the
+	 * array only has to be private to the thread, not to the distribution */
+	static THREAD_LOCAL long *set = NULL;
+	static THREAD_LOCAL int set_size = 0;
 	
 	if (d != NULL)
 		{
-		if (d->permute == (long *)NULL)
+		if (set_size < DIST_SIZE(d))
 			{
-			d->permute = (long *)malloc(sizeof(long) * DIST_SIZE(d));
-			MALLOC_CHECK(d->permute);
-			for (i=0; i < DIST_SIZE(d); i++) 
-				*(d->permute + i) = i;
+			set = (long *)realloc(set, sizeof(long) * DIST_SIZE(d));
+			MALLOC_CHECK(set);
+			set_size = DIST_SIZE(d);
 			}
 		dist = d;
-		return(permute(dist->permute, DIST_SIZE(dist), stream));
+		return(permute(set, DIST_SIZE(dist), stream));
 		}
 	
 	
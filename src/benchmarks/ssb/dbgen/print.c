@@ -25,12 +25,23 @@
 FILE *print_prep PROTO((int table, int update));
 int pr_drange PROTO((int tbl, DSS_HUGE min, DSS_HUGE cnt, long num));
 
+/*
+ * when set, the rows of a table go to print_target[table] in place of its
+ * file; pload() points them at buffers of the generating thread
+ */
+THREAD_LOCAL FILE *print_target[MAX_TABLE];
+
+#define ROW_BUF_SIZE	4096
+#define PRINT_BUF_SIZE	(1 << 20)	/* stdio buffer of an output file */
+
 FILE *
 print_prep(int table, int update)
 {
 	char upath[128];
 	FILE *res;
 
+	if (print_target[table] != NULL)
+		return(print_target[table]);
 	if (updates)
 		{
 		if (update > 0) /* updates */
@@ -64,13 +75,87 @@ print_prep(int table, int update)
 				sprintf(upath, "%s%cdelete.%d",
 				env_config(PATH_TAG, PATH_DFLT), PATH_SEP, -update);
 				}
-		return(fopen(upath, "w"));
+		res = fopen(upath, "w");
+		if (res != NULL)
+			setvbuf(res, NULL, _IOFBF, PRINT_BUF_SIZE);
+		return(res);
         }
     res = tbl_open(table, "w");
     OPEN_CHECK(res, tdefs[table].name);
+    setvbuf(res, NULL, _IOFBF, PRINT_BUF_SIZE);
     return(res);
 }
 
+/*
+ * the fields of a row are formatted by hand into row_buf and the row is
+ * written with a single fwrite() by dbg_end(); the format parsing of one
+ * fprintf() per field was most of the time spent printing a row
+ */
+static THREAD_LOCAL char row_buf[ROW_BUF_SIZE];
+static THREAD_LOCAL int row_len = 0;
+
+static void
+row_flush(FILE *target)
+{
+	fwrite(row_buf, 1, row_len, target);
+	row_len = 0;
+}
+
+static void
+row_char(FILE *target, char c)
+{
+	if (row_len == ROW_BUF_SIZE)
+		row_flush(target);
+	row_buf[row_len++] = c;
+}
+
+/* as "%-*s" */
+static void
+row_str(FILE *target, char *str, int width)
+{
+	int len = (int)strlen(str);
+	int n;
+
+	while (len > 0)
+		{
+		if (row_len == ROW_BUF_SIZE)
+			row_flush(target);
+		n = MIN(len, ROW_BUF_SIZE - row_len);
+		memcpy(row_buf + row_len, str, n);
+		row_len += n;
+		str += n;
+		len -= n;
+		width -= n;
+		}
+	for (; width > 0; width--)
+		row_char(target, ' ');
+}
+
+/* as "%*ld", or "%0*ld" with pad '0' */
+static void
+row_num(FILE *target, DSS_HUGE value, int width, char pad)
+{
+	char digits[24];
+	int n = 0;
+	int negative = (value < 0);
+	unsigned long long v;
+
+	v = (negative) ? -(unsigned long long)value : (unsigned long long)value;
+	do
+		{
+		digits[n++] = (char)('0' + v % 10);
+		v /= 10;
+		} while (v);
+	if (negative && pad == '0')
+		row_char(target, '-');
+	for (width -= n + negative; width > 0; width--)
+		row_char(target, pad);
+	if (negative && pad != '0')
+		row_char(target, '-');
+	while (n)
+		row_char(target, digits[--n]);
+}
+
 int
 dbg_print(int format, FILE *target, void *data, int len, int sep)
 {
@@ -83,64 +168,63 @@ dbg_print(int format, FILE *target, void *data, int len, int sep)
 		if (columnar)
 			/* Note: Columnar output cannot be in CSV format, */
 			/* so there's no sense in quoting the string.     */
-			fprintf(target, "%-*s", len, (char *)data);
+			row_str(target, (char *)data, len);
 		else
+			{
 #ifdef DOUBLE_QUOTE_OUTPUT_STRINGS
-			fprintf(target, "\"%s\"", (char *)data);
+			row_char(target, '"');
+			row_str(target, (char *)data, 0);
+			row_char(target, '"');
 #else
-			fprintf(target, "%s", (char *)data);
+			row_str(target, (char *)data, 0);
 #endif
+			}
 		break;
 #ifdef MVS
 	case DT_VSTR:
 		/* note: only used in MVS, assumes columnar output */
-		fprintf(target, "%c%c%-*s", 
-			(len >> 8) & 0xFF, len & 0xFF, len, (char *)data);
+		row_char(target, (char)((len >> 8) & 0xFF));
+		row_char(target, (char)(len & 0xFF));
+		row_str(target, (char *)data, len);
 		break;
 #endif /* MVS */
 	case DT_INT:
-		if (columnar)
-			fprintf(target, "%12ld", *(long *)data);
-		else
-			fprintf(target, "%ld", *(long *)data);
+		row_num(target, *(long *)data, (columnar) ? 12 : 0, ' ');
 		break;
 	case DT_HUGE:
 #ifndef SUPPORT_64BITS
 		/* Note: Next block seems to assume little-endian memory order */
         if (*((long *)data + 1) == 0) \
-           if (columnar) fprintf(target, "%12ld", *(long *)data);
-           else fprintf(target, "%ld", *(long *)data);
+           row_num(target, *(long *)data, (columnar) ? 12 : 0, ' ');
         else
-           if (columnar) fprintf(target, "%5ld%07ld", 
-				*((long *)data + 1), *(long *)data);
-           else fprintf(target,"%ld%07ld", 
-				*((long *)data + 1), *(long *)data);
+           {
+           row_num(target, *((long *)data + 1), (columnar) ? 5 : 0, ' ');
+           row_num(target, *(long *)data, 7, '0');
+           }
 #else
-		fprintf(target, HUGE_FORMAT, *(DSS_HUGE *)data);
+		row_num(target, *(DSS_HUGE *)data, 0, ' ');
 #endif /* SUPPORT_64BITS */
 		break;
 	case DT_KEY:
-		fprintf(target, "%ld", *(long *)data);
+		row_num(target, *(long *)data, 0, ' ');
 		break;
 	case DT_MONEY:
 		cents = *(long *)data;
 		if (cents < 0)
 			{
-			fprintf(target, "-");
+			row_char(target, '-');
 			cents = -cents;
 			}
 		dollars = cents / 100;
 		cents %= 100;
-		if (columnar)
-			fprintf(target, "%12d.%02d", dollars, cents);
-		else
-			fprintf(target, "%d.%02d", dollars, cents);
+		row_num(target, dollars, (columnar) ? 12 : 0, ' ');
+		row_char(target, '.');
+		row_num(target, cents, 2, '0');
 		break;
 	case DT_CHR:
+		row_char(target, *(char *)data);
 		if (columnar)
-			fprintf(target, "%c ", *(char *)data);
-		else
-			fprintf(target, "%c", *(char *)data);
+			row_char(target, ' ');
 		break;
 	}
 
@@ -148,16 +232,25 @@ dbg_print(int format, FILE *target, void *data, int len, int sep)
 	if (sep)
 #endif /* EOL_HANDLING */
 	if (!columnar && (sep != -1))
-		fprintf(target, "%c", SEPARATOR);
+		row_char(target, SEPARATOR);
 	
 	return(0);
 }
 
+int
+dbg_end(FILE *target)
+{
+	row_char(target, '\n');
+	row_flush(target);
+
+	return(0);
+}
+
 #ifdef SSB
 int
 pr_cust(customer_t *c, int mode)
 {
-static FILE *fp = NULL;
+static THREAD_LOCAL FILE *fp = NULL;
 
    UNUSED(mode);
    if (fp == NULL)
@@ -182,7 +275,8 @@ static FILE *fp = NULL;
 int
 pr_cust(customer_t *c, int mode)
 {
-static FILE *fp = NULL;
+static THREAD_LOCAL FILE *fp = NULL;
+    UNUSED(mode);
         
    if (fp == NULL)
         fp = print_prep(CUST, 0);
@@ -213,8 +307,8 @@ static FILE *fp = NULL;
 int
 pr_order(order_t *o, int mode)
 {
-    static FILE *fp_o = NULL;
-    static int last_mode = 0;
+    static THREAD_LOCAL FILE *fp_o = NULL;
+    static THREAD_LOCAL int last_mode = 0;
         
     if (fp_o == NULL || mode != last_mode)
         {
@@ -248,8 +342,8 @@ int
 pr_line(order_t *o, int mode)
 {
 
-    static FILE *fp_l = NULL;
-    static int last_mode = 0;
+    static THREAD_LOCAL FILE *fp_l = NULL;
+    static THREAD_LOCAL int last_mode = 0;
     long      i;
     /* int days; */
     /* char buf[100]; */
@@ -291,11 +385,9 @@ pr_line(order_t *o, int mode)
 int
 pr_line(order_t *o, int mode)
 {
-    static FILE *fp_l = NULL;
-    static int last_mode = 0;
+    static THREAD_LOCAL FILE *fp_l = NULL;
+    static THREAD_LOCAL int last_mode = 0;
     long      i;
-    int days;
-    char buf[100];
 
     if (fp_l == NULL || mode != last_mode)
         {
@@ -356,7 +448,7 @@ pr_order_line(order_t *o, int mode)
 int
 pr_part(part_t *part, int mode)
 {
-    static FILE *p_fp = NULL;
+    static THREAD_LOCAL FILE *p_fp = NULL;
 
     UNUSED(mode);
     if (p_fp == NULL)
@@ -384,7 +476,8 @@ pr_part(part_t *part, int mode)
 int
 pr_part(part_t *part, int mode)
 {
-static FILE *p_fp = NULL;
+static THREAD_LOCAL FILE *p_fp = NULL;
+    UNUSED(mode);
 
     if (p_fp == NULL)
         p_fp = print_prep(PART, 0);
@@ -417,7 +510,7 @@ static FILE *p_fp = NULL;
 int
 pr_psupp(part_t *part, int mode)
 {
-    static FILE *ps_fp = NULL;
+    static THREAD_LOCAL FILE *ps_fp = NULL;
     long      i;
 
     if (ps_fp == NULL)
@@ -461,7 +554,7 @@ pr_part_psupp(part_t *part, int mode)
 int
 pr_supp(supplier_t *supp, int mode)
 {
-    static FILE *fp = NULL;
+    static THREAD_LOCAL FILE *fp = NULL;
 
     if (fp == NULL)
         fp = print_prep(SUPP, mode);
@@ -484,7 +577,7 @@ pr_supp(supplier_t *supp, int mode)
 int
 pr_supp(supplier_t *supp, int mode)
 {
-static FILE *fp = NULL;
+static THREAD_LOCAL FILE *fp = NULL;
         
    if (fp == NULL)
         fp = print_prep(SUPP, mode);
@@ -510,7 +603,7 @@ static FILE *fp = NULL;
 int
 pr_nation(code_t *c, int mode)
 {
-static FILE *fp = NULL;
+static THREAD_LOCAL FILE *fp = NULL;
         
    if (fp == NULL)
         fp = print_prep(NATION, mode);
@@ -529,7 +622,7 @@ static FILE *fp = NULL;
 int
 pr_region(code_t *c, int mode)
 {
-static FILE *fp = NULL;
+static THREAD_LOCAL FILE *fp = NULL;
         
    if (fp == NULL)
         fp = print_prep(REGION, mode);
@@ -655,7 +748,7 @@ pr_drange(int tbl, DSS_HUGE min, DSS_HUGE cnt, long num)
 
 #ifdef SSB
 int pr_date(date_t *d, int mode){
-    static FILE *d_fp = NULL;
+    static THREAD_LOCAL FILE *d_fp = NULL;
     
     UNUSED(mode);
     if (d_fp == NULL)
@@ -724,6 +817,7 @@ vrf_cust(customer_t *c, int mode)
 int
 vrf_cust(customer_t *c, int mode)
 {
+   UNUSED(mode);
    VRF_STRT(CUST);
    VRF_INT(CUST, c->custkey);
    VRF_STR(CUST, c->name);
@@ -747,6 +841,7 @@ vrf_cust(customer_t *c, int mode)
 int
 vrf_order(order_t *o, int mode)
 {
+    UNUSED(mode);
     VRF_STRT(ORDER);
     VRF_HUGE(ORDER, o->okey);
     VRF_INT(ORDER, o->custkey);
@@ -804,6 +899,7 @@ int
 vrf_line(order_t *o, int mode)
 {
 	int i;
+    UNUSED(mode);
 
     for (i = 0; i < o->lines; i++)
         {
@@ -873,6 +969,7 @@ vrf_part(part_t *part, int mode)
 int
 vrf_part(part_t *part, int mode)
 {
+   UNUSED(mode);
 
    VRF_STRT(PART);
    VRF_INT(PART, part->partkey);
@@ -899,6 +996,7 @@ int
 vrf_psupp(part_t *part, int mode)
 {
     long      i;
+    UNUSED(mode);
 
    for (i = 0; i < SUPP_PER_PART; i++)
       {
@@ -954,6 +1052,7 @@ vrf_supp(supplier_t *supp, int mode)
 int
 vrf_supp(supplier_t *supp, int mode)
 {
+   UNUSED(mode);
    VRF_STRT(SUPP);
    VRF_INT(SUPP, supp->suppkey);
    VRF_STR(SUPP, supp->name);
@@ -973,6 +1072,7 @@ vrf_supp(supplier_t *supp, int mode)
 int
 vrf_nation(code_t *c, int mode)
 {
+   UNUSED(mode);
    VRF_STRT(NATION);
    VRF_INT(NATION, c->code);
    VRF_STR(NATION, c->text);
@@ -986,6 +1086,7 @@ vrf_nation(code_t *c, int mode)
 int
 vrf_region(code_t *c, int mode)
 {
+   UNUSED(mode);
    VRF_STRT(REGION);
    VRF_INT(REGION, c->code);
    VRF_STR(REGION, c->text);
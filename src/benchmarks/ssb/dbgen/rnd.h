@@ -27,7 +27,7 @@ static double   dM = 2147483647.0;
  * preferred solution, but not initializing correctly
  */
 #define VSTR_MAX(len)	(long)(len / 5 + (len % 5 == 0)?0:1 + 1)
-seed_t     Seed[MAX_STREAM + 1] =
+THREAD_LOCAL seed_t Seed[MAX_STREAM + 1] =
 {
     {PART,   1,          0,	1},					/* P_MFG_SD     0 */
     {PART,   46831694,   0, 1},					/* P_BRND_SD    1 */
@@ -14,7 +14,6 @@
 
 #define MAX_COLOR 92
 long name_bits[MAX_COLOR / BITS_PER_LONG];
-extern seed_t Seed[];
 
 /* WARNING!  This routine assumes the existence of 64-bit                 */
 /* integers.  The notation used here- "HUGE" is *not* ANSI standard. */
@@ -49,7 +48,7 @@ void NthElement (long N, long *StartSeed)
    {
    DSS_HUGE Z;
    DSS_HUGE Mult;
-   static int ln=-1;
+   static THREAD_LOCAL int ln=-1;
    int i;
 
    if ((verbose > 0) && ++ln % 1000 == 0)
@@ -158,7 +157,7 @@ NthElement ( long Shift, long *Seed)
 
 {
    RND Power;
-   static int ln=-1;
+   static THREAD_LOCAL int ln=-1;
    int i;
 
    if ((verbose > 0) && ++ln % 100 == 0)
@@ -249,6 +248,9 @@ sd_part(int child, long skip_count)
  
    FAKE_V_STR(P_CMNT_LEN, P_CMNT_SD, skip_count);
    ADVANCE_STREAM(P_NAME_SD, skip_count * 92);
+#ifdef SSB
+   ADVANCE_STREAM(P_CAT_SD, skip_count);
+#endif
 
    return(0L);
 }
@@ -265,12 +267,26 @@ sd_line(int child, long skip_count)
 		}
 	
 	FAKE_V_STR(L_CMNT_LEN, L_CMNT_SD, skip_count);
+#ifdef SSB
+	ADVANCE_STREAM(HVAR_SD, skip_count);
+	/* the lineorder table is also the order table of SSB: mk_order() draws
+	 * once a row on each of the order streams it uses */
+	if (child == 1)
+		{
+		ADVANCE_STREAM(O_ODATE_SD, skip_count);
+		ADVANCE_STREAM(O_CKEY_SD, skip_count);
+		ADVANCE_STREAM(O_PRIO_SD, skip_count);
+		ADVANCE_STREAM(O_CLRK_SD, skip_count);
+		ADVANCE_STREAM(O_LCNT_SD, skip_count);
+		}
+#else
 	/* need to special case this as the link between master and detail */
 	if (child == 1)
 		{
 		ADVANCE_STREAM(O_ODATE_SD, skip_count);
 		ADVANCE_STREAM(O_LCNT_SD, skip_count);
 		}
+#endif
 		
 	return(0L);
 	}
@@ -316,6 +332,10 @@ sd_cust(int child, long skip_count)
    ADVANCE_STREAM(C_PHNE_SD, 3L * skip_count);
    ADVANCE_STREAM(C_ABAL_SD, skip_count);
    ADVANCE_STREAM(C_MSEG_SD, skip_count);
+#ifdef SSB
+   /* gen_city() draws on the city stream of the supplier table */
+   ADVANCE_STREAM(P_CITY_SD, skip_count);
+#endif
    return(0L);
 }
 
@@ -332,6 +352,29 @@ sd_supp(int child, long skip_count)
    ADVANCE_STREAM(BBB_JNK_SD, skip_count);
    ADVANCE_STREAM(BBB_OFFSET_SD, skip_count);
    ADVANCE_STREAM(BBB_TYPE_SD, skip_count);      /* avoid one trudge */
+#ifdef SSB
+   /* mk_supp() takes the phone numbers from the customer stream */
+   ADVANCE_STREAM(P_CITY_SD, skip_count);
+   ADVANCE_STREAM(C_PHNE_SD, 3L * skip_count);
+#endif
    
    return(0L);
 }
+
+#ifdef SSB
+/* mk_date() draws on no stream, but the date table has the number of the
+ * order table, so row_stop() moves the order streams that mk_order() uses
+ * to their boundaries after every date */
+long
+sd_date(int child, long skip_count)
+{
+   int i;
+
+   UNUSED(child);
+   for (i = 0; i <= MAX_STREAM; i++)
+       if (Seed[i].table == DATE)
+           ADVANCE_STREAM(i, Seed[i].boundary * skip_count);
+
+   return(0L);
+}
+#endif
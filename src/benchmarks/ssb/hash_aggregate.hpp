@@ -0,0 +1,260 @@
+#ifndef SQLITE_PERFORMANCE_SSB_HASH_AGGREGATE_HPP
+#define SQLITE_PERFORMANCE_SSB_HASH_AGGREGATE_HPP
+
+// A table-valued function that groups the rows of a query in a hash table
+// instead of sorting them:
+//
+//   SELECT k0 AS d_year, k1 AS p_brand1, total
+//   FROM hash_aggregate('SELECT d_year, p_brand1, lo_revenue FROM ...')
+//   ORDER BY d_year, p_brand1;
+//
+// The last column of the query is summed over the groups formed by the
+// others, of which there may be up to four. Keys are returned as k0..k3 and
+// the sum as total, with the semantics of SUM: NULLs are ignored, the sum of
+// integers is an integer and an error if it overflows, and any other value
+// makes it a floating point sum. SQLite sorts every input row for GROUP BY;
+// here only the groups are left for the ORDER BY to sort.
+
+#include "sqlite3.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+constexpr int hash_aggregate_max_keys = 4;
+
+struct HashAggregateGroup {
+  std::vector<sqlite3_value *> keys;
+  sqlite3_int64 int_total = 0;
+  double real_total = 0;
+  bool any = false;
+  bool real = false;
+  bool overflow = false;
+};
+
+struct HashAggregateTable {
+  sqlite3_vtab base;
+  sqlite3 *db;
+};
+
+struct HashAggregateCursor {
+  sqlite3_vtab_cursor base;
+  std::vector<HashAggregateGroup> groups;
+  size_t pos = 0;
+
+  ~HashAggregateCursor() { clear(); }
+
+  void clear() {
+    for (HashAggregateGroup &group : groups) {
+      for (sqlite3_value *key : group.keys) {
+        sqlite3_value_free(key);
+      }
+    }
+    groups.clear();
+  }
+};
+
+int hash_aggregate_connect(sqlite3 *db, void *, int, const char *const *,
+                           sqlite3_vtab **pp_vtab, char **) {
+  int rc = sqlite3_declare_vtab(
+      db, "CREATE TABLE x(k0, k1, k2, k3, total, query HIDDEN)");
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+  auto *table = new HashAggregateTable();
+  table->db = db;
+  *pp_vtab = &table->base;
+  return SQLITE_OK;
+}
+
+int hash_aggregate_disconnect(sqlite3_vtab *vtab) {
+  delete (HashAggregateTable *)vtab;
+  return SQLITE_OK;
+}
+
+// The query argument is required.
+int hash_aggregate_best_index(sqlite3_vtab *, sqlite3_index_info *info) {
+  for (int i = 0; i < info->nConstraint; ++i) {
+    const auto &constraint = info->aConstraint[i];
+    if (constraint.iColumn == hash_aggregate_max_keys + 1 &&
+        constraint.op == SQLITE_INDEX_CONSTRAINT_EQ) {
+      if (!constraint.usable) {
+        return SQLITE_CONSTRAINT;
+      }
+      info->aConstraintUsage[i].argvIndex = 1;
+      info->aConstraintUsage[i].omit = 1;
+      info->estimatedCost = 1000000;
+      info->estimatedRows = 1000;
+      return SQLITE_OK;
+    }
+  }
+  return SQLITE_CONSTRAINT;
+}
+
+int hash_aggregate_open(sqlite3_vtab *, sqlite3_vtab_cursor **pp_cursor) {
+  *pp_cursor = &(new HashAggregateCursor())->base;
+  return SQLITE_OK;
+}
+
+int hash_aggregate_close(sqlite3_vtab_cursor *cur) {
+  delete (HashAggregateCursor *)cur;
+  return SQLITE_OK;
+}
+
+// Appends a value to the key that identifies its group: the type, then the
+// number or the length and bytes of the text.
+void hash_aggregate_key(std::string &key, sqlite3_value *value) {
+  int type = sqlite3_value_type(value);
+  key += (char)type;
+  if (type == SQLITE_INTEGER) {
+    sqlite3_int64 i = sqlite3_value_int64(value);
+    key.append((const char *)&i, sizeof(i));
+  } else if (type == SQLITE_FLOAT) {
+    double d = sqlite3_value_double(value);
+    key.append((const char *)&d, sizeof(d));
+  } else if (type != SQLITE_NULL) {
+    auto size = (uint32_t)sqlite3_value_bytes(value);
+    key.append((const char *)&size, sizeof(size));
+    key.append((const char *)sqlite3_value_blob(value), size);
+  }
+}
+
+void hash_aggregate_add(HashAggregateGroup &group, sqlite3_value *value) {
+  int type = sqlite3_value_type(value);
+  if (type == SQLITE_NULL) {
+    return;
+  }
+  group.any = true;
+  group.real_total += sqlite3_value_double(value);
+  if (type == SQLITE_INTEGER) {
+    group.overflow |= __builtin_add_overflow(
+        group.int_total, sqlite3_value_int64(value), &group.int_total);
+  } else {
+    group.real = true;
+  }
+}
+
+int hash_aggregate_filter(sqlite3_vtab_cursor *cur, int, const char *, int,
+                          sqlite3_value **argv) {
+  auto *cursor = (HashAggregateCursor *)cur;
+  auto *table = (HashAggregateTable *)cur->pVtab;
+  cursor->clear();
+  cursor->pos = 0;
+
+  sqlite3_stmt *stmt;
+  auto *sql = (const char *)sqlite3_value_text(argv[0]);
+  int rc = sqlite3_prepare_v2(table->db, sql, -1, &stmt, nullptr);
+  if (rc != SQLITE_OK) {
+    table->base.zErrMsg =
+        sqlite3_mprintf("hash_aggregate: %s", sqlite3_errmsg(table->db));
+    return rc;
+  }
+  int n_keys = sqlite3_column_count(stmt) - 1;
+  if (n_keys < 0 || n_keys > hash_aggregate_max_keys) {
+    sqlite3_finalize(stmt);
+    table->base.zErrMsg = sqlite3_mprintf(
+        "hash_aggregate: the query must return 1 to %d columns",
+        hash_aggregate_max_keys + 1);
+    return SQLITE_ERROR;
+  }
+
+  std::unordered_map<std::string, size_t> index;
+  std::string key;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    key.clear();
+    for (int i = 0; i < n_keys; ++i) {
+      hash_aggregate_key(key, sqlite3_column_value(stmt, i));
+    }
+    auto it = index.find(key);
+    if (it == index.end()) {
+      it = index.emplace(key, cursor->groups.size()).first;
+      cursor->groups.emplace_back();
+      for (int i = 0; i < n_keys; ++i) {
+        cursor->groups.back().keys.push_back(
+            sqlite3_value_dup(sqlite3_column_value(stmt, i)));
+      }
+    }
+    hash_aggregate_add(cursor->groups[it->second],
+                       sqlite3_column_value(stmt, n_keys));
+  }
+  sqlite3_finalize(stmt);
+  if (rc != SQLITE_DONE) {
+    table->base.zErrMsg =
+        sqlite3_mprintf("hash_aggregate: %s", sqlite3_errmsg(table->db));
+    return rc;
+  }
+
+  // Without grouping columns, SUM returns one row even for no input.
+  if (n_keys == 0 && cursor->groups.empty()) {
+    cursor->groups.emplace_back();
+  }
+  return SQLITE_OK;
+}
+
+int hash_aggregate_next(sqlite3_vtab_cursor *cur) {
+  ++((HashAggregateCursor *)cur)->pos;
+  return SQLITE_OK;
+}
+
+int hash_aggregate_eof(sqlite3_vtab_cursor *cur) {
+  auto *cursor = (HashAggregateCursor *)cur;
+  return cursor->pos >= cursor->groups.size();
+}
+
+int hash_aggregate_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx,
+                          int i) {
+  auto *cursor = (HashAggregateCursor *)cur;
+  const HashAggregateGroup &group = cursor->groups[cursor->pos];
+  if (i < (int)group.keys.size()) {
+    sqlite3_result_value(ctx, group.keys[i]);
+  } else if (i != hash_aggregate_max_keys || !group.any) {
+    sqlite3_result_null(ctx);
+  } else if (group.real) {
+    sqlite3_result_double(ctx, group.real_total);
+  } else if (group.overflow) {
+    sqlite3_result_error(ctx, "integer overflow", -1);
+  } else {
+    sqlite3_result_int64(ctx, group.int_total);
+  }
+  return SQLITE_OK;
+}
+
+int hash_aggregate_rowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid) {
+  *rowid = (sqlite3_int64)((HashAggregateCursor *)cur)->pos;
+  return SQLITE_OK;
+}
+
+sqlite3_module hash_aggregate_module = {
+    0,                         // iVersion
+    nullptr,                   // xCreate
+    hash_aggregate_connect,    // xConnect
+    hash_aggregate_best_index, // xBestIndex
+    hash_aggregate_disconnect, // xDisconnect
+    nullptr,                   // xDestroy
+    hash_aggregate_open,       // xOpen
+    hash_aggregate_close,      // xClose
+    hash_aggregate_filter,     // xFilter
+    hash_aggregate_next,       // xNext
+    hash_aggregate_eof,        // xEof
+    hash_aggregate_column,     // xColumn
+    hash_aggregate_rowid,      // xRowid
+    nullptr,                   // xUpdate
+    nullptr,                   // xBegin
+    nullptr,                   // xSync
+    nullptr,                   // xCommit
+    nullptr,                   // xRollback
+    nullptr,                   // xFindFunction
+    nullptr,                   // xRename
+    nullptr,                   // xSavepoint
+    nullptr,                   // xRelease
+    nullptr,                   // xRollbackTo
+    nullptr,                   // xShadowName
+};
+
+int create_hash_aggregate_module(sqlite3 *db) {
+  return sqlite3_create_module(db, "hash_aggregate", &hash_aggregate_module,
+                               nullptr);
+}
+
+#endif // SQLITE_PERFORMANCE_SSB_HASH_AGGREGATE_HPP
@@ -0,0 +1,577 @@
+#ifndef SQLITE_PERFORMANCE_SSB_HASH_JOIN_HPP
+#define SQLITE_PERFORMANCE_SSB_HASH_JOIN_HPP
+
+// A virtual table that answers key lookups into a table of the main schema
+// from an in-memory hash table instead of a B-tree search per probe:
+//
+//   CREATE VIRTUAL TABLE temp.part USING hash_join(part);
+//
+// The table must have an INTEGER PRIMARY KEY. When the planner puts it on the
+// inner side of a join on that key, the first probe builds a hash table from
+// the rows that satisfy the constant constraints on the other columns, and
+// every later probe is a hash lookup. The build is kept for as long as those
+// constants stay the same, which for a join is the whole statement.
+//
+// If the module is created with a Bloom filter registry, each build also
+// publishes a filter over its keys, which batch_scan uses to drop fact table
+// rows that cannot join.
+
+#include "bloom_filter.hpp"
+#include "sqlite3.h"
+#include "vtab.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Open-addressing hash table from unique 64-bit keys to row numbers.
+class HashIndex {
+public:
+  void build(const std::vector<sqlite3_int64> &keys) {
+    size_t capacity = 16;
+    shift_ = 60;
+    while (capacity < 2 * keys.size()) {
+      capacity *= 2;
+      --shift_;
+    }
+    mask_ = capacity - 1;
+    slots_.assign(capacity, Slot{0, empty});
+    for (size_t row = 0; row < keys.size(); ++row) {
+      size_t i = slot(keys[row]);
+      while (slots_[i].row != empty) {
+        i = (i + 1) & mask_;
+      }
+      slots_[i] = Slot{keys[row], (uint32_t)row};
+    }
+  }
+
+  void prefetch(sqlite3_int64 key) const {
+    __builtin_prefetch(&slots_[slot(key)]);
+  }
+
+  bool find(sqlite3_int64 key, uint32_t &row) const {
+    for (size_t i = slot(key);; i = (i + 1) & mask_) {
+      if (slots_[i].row == empty) {
+        return false;
+      }
+      if (slots_[i].key == key) {
+        row = slots_[i].row;
+        return true;
+      }
+    }
+  }
+
+private:
+  static constexpr uint32_t empty = UINT32_MAX;
+
+  struct Slot {
+    sqlite3_int64 key;
+    uint32_t row;
+  };
+
+  size_t slot(sqlite3_int64 key) const {
+    return (size_t)(((uint64_t)key * 0x9e3779b97f4a7c15ull) >> shift_);
+  }
+
+  std::vector<Slot> slots_;
+  size_t mask_ = 0;
+  int shift_ = 60;
+};
+
+// The rows of the build side, decoded into column vectors.
+struct HashJoinBuild {
+  // The plan and constants the build was made for. The values of an IN list
+  // are stored in order in place of the list, and in_lists holds the number
+  // of them per argument, or -1 for an argument that is not a list.
+  bool valid = false;
+  std::string plan;
+  std::vector<sqlite3_value *> constants;
+  std::vector<int> in_lists;
+
+  std::vector<sqlite3_int64> keys;
+  std::vector<ColumnVector> columns;
+  HashIndex index;
+  std::unique_ptr<BloomFilter> filter;
+  // The subtype of the probe keys as recorded in the registry, 0 before the
+  // first probe.
+  int probed_with = 0;
+
+  HashJoinBuild() = default;
+  HashJoinBuild(const HashJoinBuild &) = delete;
+  HashJoinBuild &operator=(const HashJoinBuild &) = delete;
+
+  ~HashJoinBuild() { clear_constants(); }
+
+  void clear_constants() {
+    for (sqlite3_value *value : constants) {
+      sqlite3_value_free(value);
+    }
+    constants.clear();
+  }
+};
+
+struct HashJoinTable {
+  sqlite3_vtab base;
+  sqlite3 *db;
+  std::string name;
+  VtabColumns columns;
+  double n_rows;
+  BloomFilterRegistry *filters;
+};
+
+struct HashJoinCursor {
+  sqlite3_vtab_cursor base;
+  HashJoinBuild build;
+  // Rows of the build returned by the current scan: the matching row of a
+  // probe, or every row when there is no key to probe with.
+  bool probe = false;
+  bool found = false;
+  uint32_t row = 0;
+  bool eof = true;
+};
+
+int hash_join_connect(sqlite3 *db, void *aux, int argc,
+                      const char *const *argv, sqlite3_vtab **pp_vtab,
+                      char **pz_err) {
+  if (argc != 4) {
+    *pz_err = sqlite3_mprintf("hash_join: expected one argument, the table");
+    return SQLITE_ERROR;
+  }
+
+  auto *table = new HashJoinTable();
+  table->db = db;
+  table->name = argv[3];
+  table->filters = (BloomFilterRegistry *)aux;
+
+  int rc = vtab_columns(db, "hash_join", table->name, table->columns, pz_err);
+  if (rc == SQLITE_OK && table->columns.rowid_alias < 0) {
+    *pz_err = sqlite3_mprintf("hash_join: %s has no INTEGER PRIMARY KEY",
+                              table->name.c_str());
+    rc = SQLITE_ERROR;
+  }
+  if (rc == SQLITE_OK) {
+    rc = vtab_declare(db, table->columns);
+  }
+  if (rc != SQLITE_OK) {
+    delete table;
+    return rc;
+  }
+  table->n_rows = vtab_row_estimate(db, table->name);
+
+  *pp_vtab = &table->base;
+  return SQLITE_OK;
+}
+
+int hash_join_disconnect(sqlite3_vtab *vtab) {
+  delete (HashJoinTable *)vtab;
+  return SQLITE_OK;
+}
+
+// The op that the plan gives an IN constraint, whose argument is the list.
+constexpr int hash_join_in_list = 0;
+
+// Whether constraint i is an IN list that SQLite can hand over whole, for the
+// build query to evaluate. Like a constant, it must compare with the
+// column's own collation.
+bool hash_join_in_constraint(sqlite3_index_info *info, int i,
+                             const VtabColumns &columns) {
+  const auto &constraint = info->aConstraint[i];
+  return constraint.usable && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ &&
+         (columns.integer[constraint.iColumn] ||
+          sqlite3_stricmp(sqlite3_vtab_collation(info, i), "BINARY") == 0) &&
+         sqlite3_vtab_in(info, i, -1);
+}
+
+// idxNum is 1 when argv[0] is the key to probe with. The remaining arguments
+// are constants that restrict the build side, and IN lists if there is no
+// key: a probe would have to walk the lists on every call to tell whether
+// the build still matches them, which costs more than letting SQLite check
+// the rows that the probes return. idxStr holds the colUsed mask followed by
+// one "column op" pair for each argument.
+int hash_join_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info) {
+  auto *table = (HashJoinTable *)vtab;
+
+  int key = -1;
+  for (int i = 0; i < info->nConstraint && key < 0; ++i) {
+    const auto &constraint = info->aConstraint[i];
+    if (constraint.usable && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ &&
+        (constraint.iColumn < 0 ||
+         constraint.iColumn == table->columns.rowid_alias)) {
+      key = i;
+    }
+  }
+
+  std::ostringstream plan;
+  plan << info->colUsed;
+
+  int argv_index = 0;
+  if (key >= 0) {
+    info->aConstraintUsage[key].argvIndex = ++argv_index;
+    info->aConstraintUsage[key].omit = 1;
+  }
+
+  bool unprobed_key = false;
+  for (int i = 0; i < info->nConstraint; ++i) {
+    const auto &constraint = info->aConstraint[i];
+    if (constraint.iColumn < 0 ||
+        constraint.iColumn == table->columns.rowid_alias) {
+      unprobed_key = unprobed_key ||
+                     (key < 0 && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ);
+      continue;
+    }
+    int op;
+    if (vtab_constant_constraint(info, i, table->columns)) {
+      op = constraint.op;
+    } else if (key < 0 && hash_join_in_constraint(info, i, table->columns)) {
+      op = hash_join_in_list;
+      sqlite3_vtab_in(info, i, 1);
+    } else {
+      continue;
+    }
+    info->aConstraintUsage[i].argvIndex = ++argv_index;
+    info->aConstraintUsage[i].omit = 1;
+    plan << " " << constraint.iColumn << " " << op;
+  }
+
+  info->idxNum = key >= 0;
+  info->idxStr = sqlite3_mprintf("%s", plan.str().c_str());
+  info->needToFreeIdxStr = 1;
+  if (key >= 0) {
+    info->estimatedRows = 1;
+    info->estimatedCost = 1;
+    info->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
+  } else {
+    // Claiming the selectivity of the build constraints makes the planner put
+    // the small dimension tables outermost, so a scan is estimated to return
+    // every row. That alone does not keep a dimension that the statement
+    // joins on its key from being scanned outside the fact table, each of its
+    // rows then searching the fact table through an automatic index. So such
+    // a scan costs a full scan of a table of vtab_row_estimate's default size
+    // per row.
+    info->estimatedRows = (sqlite3_int64)table->n_rows;
+    info->estimatedCost =
+        unprobed_key ? table->n_rows * 1000000 : table->n_rows;
+  }
+  return SQLITE_OK;
+}
+
+int hash_join_open(sqlite3_vtab *, sqlite3_vtab_cursor **pp_cursor) {
+  *pp_cursor = &(new HashJoinCursor())->base;
+  return SQLITE_OK;
+}
+
+// Withdraws the Bloom filter of the build, if one was published.
+void hash_join_unpublish(HashJoinCursor *cursor) {
+  auto *table = (HashJoinTable *)cursor->base.pVtab;
+  if (cursor->build.filter != nullptr) {
+    table->filters->unpublish(table->name, cursor->build.filter.get());
+    cursor->build.filter.reset();
+  }
+  if (table->filters != nullptr) {
+    table->filters->unpublish_build(table->name, &cursor->build);
+  }
+}
+
+int hash_join_close(sqlite3_vtab_cursor *cur) {
+  auto *cursor = (HashJoinCursor *)cur;
+  hash_join_unpublish(cursor);
+  delete cursor;
+  return SQLITE_OK;
+}
+
+// Reads the rows of the table that satisfy the build constraints, decoding
+// the columns in colUsed, and indexes them by key.
+int hash_join_build(HashJoinCursor *cursor, const char *idx_str, int argc,
+                    sqlite3_value **argv) {
+  auto *table = (HashJoinTable *)cursor->base.pVtab;
+  HashJoinBuild &build = cursor->build;
+
+  std::istringstream plan(idx_str);
+  sqlite3_uint64 col_used;
+  plan >> col_used;
+
+  std::vector<int> decoded;
+  for (size_t column = 0; column < table->columns.names.size(); ++column) {
+    if ((int)column != table->columns.rowid_alias &&
+        (col_used & ((sqlite3_uint64)1 << std::min<size_t>(column, 63)))) {
+      decoded.push_back((int)column);
+    }
+  }
+
+  std::ostringstream sql;
+  sql << "SELECT rowid";
+  for (int column : decoded) {
+    sql << ", " << vtab_quote(table->columns.names[column]);
+  }
+  sql << " FROM main." << vtab_quote(table->name);
+  // The constants are copied as they are read: SQLite returns the values of
+  // an IN list in the same sqlite3_value.
+  build.valid = false;
+  build.clear_constants();
+  build.in_lists.clear();
+  for (int i = 0; i < argc; ++i) {
+    int column;
+    int op;
+    plan >> column >> op;
+    sql << (i == 0 ? " WHERE " : " AND ")
+        << vtab_quote(table->columns.names[column]);
+    if (op == hash_join_in_list) {
+      sql << " IN (";
+      int n = 0;
+      sqlite3_value *value;
+      int rc = sqlite3_vtab_in_first(argv[i], &value);
+      for (; rc == SQLITE_OK; rc = sqlite3_vtab_in_next(argv[i], &value)) {
+        sql << (n++ > 0 ? ", " : "") << "?" << build.constants.size() + 1;
+        build.constants.push_back(sqlite3_value_dup(value));
+      }
+      if (rc != SQLITE_DONE) {
+        return rc;
+      }
+      sql << ")";
+      build.in_lists.push_back(n);
+      continue;
+    }
+    switch (op) {
+    case SQLITE_INDEX_CONSTRAINT_EQ:
+      sql << " = ";
+      break;
+    case SQLITE_INDEX_CONSTRAINT_NE:
+      sql << " <> ";
+      break;
+    case SQLITE_INDEX_CONSTRAINT_LT:
+      sql << " < ";
+      break;
+    case SQLITE_INDEX_CONSTRAINT_LE:
+      sql << " <= ";
+      break;
+    case SQLITE_INDEX_CONSTRAINT_GT:
+      sql << " > ";
+      break;
+    case SQLITE_INDEX_CONSTRAINT_GE:
+      sql << " >= ";
+      break;
+    }
+    sql << "?" << build.constants.size() + 1;
+    build.constants.push_back(sqlite3_value_dup(argv[i]));
+    build.in_lists.push_back(-1);
+  }
+
+  sqlite3_stmt *stmt;
+  int rc = sqlite3_prepare_v2(table->db, sql.str().c_str(), -1, &stmt, nullptr);
+  if (rc != SQLITE_OK) {
+    table->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(table->db));
+    return rc;
+  }
+  for (size_t i = 0; i < build.constants.size(); ++i) {
+    sqlite3_bind_value(stmt, (int)i + 1, build.constants[i]);
+  }
+
+  hash_join_unpublish(cursor);
+  build.keys.clear();
+  build.columns.assign(table->columns.names.size(), ColumnVector());
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    build.keys.push_back(sqlite3_column_int64(stmt, 0));
+    for (size_t k = 0; k < decoded.size(); ++k) {
+      int column = decoded[k];
+      int i = (int)k + 1;
+      ColumnVector &c = build.columns[column];
+      if (table->columns.integer[column]) {
+        c.ints.push_back(sqlite3_column_int64(stmt, i));
+      } else {
+        auto *text = (const char *)sqlite3_column_text(stmt, i);
+        c.append_text(text, sqlite3_column_bytes(stmt, i));
+      }
+    }
+  }
+  sqlite3_finalize(stmt);
+  if (rc != SQLITE_DONE) {
+    table->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(table->db));
+    return rc;
+  }
+
+  build.index.build(build.keys);
+  if (table->filters != nullptr) {
+    build.filter = std::make_unique<BloomFilter>(table->filters->layout,
+                                                 build.keys.size());
+    for (sqlite3_int64 key : build.keys) {
+      build.filter->insert(key);
+    }
+    table->filters->publish(table->name, build.filter.get());
+    build.probed_with = 0;
+    if (table->filters->prefetch) {
+      table->filters->publish_build(table->name, &build);
+    }
+  }
+  build.plan = idx_str;
+  build.valid = true;
+  return SQLITE_OK;
+}
+
+bool hash_join_same_value(sqlite3_value *value, sqlite3_value *constant) {
+  int type = sqlite3_value_type(constant);
+  if (sqlite3_value_type(value) != type) {
+    return false;
+  }
+  if (type == SQLITE_INTEGER) {
+    return sqlite3_value_int64(value) == sqlite3_value_int64(constant);
+  }
+  int size = sqlite3_value_bytes(constant);
+  return sqlite3_value_bytes(value) == size &&
+         memcmp(sqlite3_value_text(value), sqlite3_value_text(constant),
+                size) == 0;
+}
+
+// Whether the build was made for this plan and these constants. Called on
+// every probe, so it compares without converting or copying the values.
+bool hash_join_is_built(const HashJoinBuild &build, const char *idx_str,
+                        int argc, sqlite3_value **argv) {
+  if (!build.valid || build.plan != idx_str ||
+      build.in_lists.size() != (size_t)argc) {
+    return false;
+  }
+  size_t j = 0;
+  for (int i = 0; i < argc; ++i) {
+    if (build.in_lists[i] < 0) {
+      if (!hash_join_same_value(argv[i], build.constants[j++])) {
+        return false;
+      }
+      continue;
+    }
+    size_t end = j + (size_t)build.in_lists[i];
+    sqlite3_value *value;
+    int rc = sqlite3_vtab_in_first(argv[i], &value);
+    for (; rc == SQLITE_OK; rc = sqlite3_vtab_in_next(argv[i], &value)) {
+      if (j == end || !hash_join_same_value(value, build.constants[j++])) {
+        return false;
+      }
+    }
+    if (rc != SQLITE_DONE || j != end) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Prefetches the slot of the hash index that a probe for the key reads
+// first. It is computed from the hash alone, without a lookup.
+void hash_join_prefetch(const HashJoinBuild &build, sqlite3_int64 key) {
+  build.index.prefetch(key);
+}
+
+// Tells the registry which column of which scan the keys come from, if they
+// all come from the same one (see BloomFilterRegistry). The registry is only
+// updated when that changes, which is at most twice per build.
+void hash_join_record_probe(HashJoinCursor *cursor, sqlite3_value *key) {
+  auto *table = (HashJoinTable *)cursor->base.pVtab;
+  HashJoinBuild &build = cursor->build;
+  int subtype = (int)sqlite3_value_subtype(key);
+  int probed_with =
+      subtype != 0 && (build.probed_with == 0 || build.probed_with == subtype)
+          ? subtype
+          : -1;
+  if (probed_with != build.probed_with) {
+    build.probed_with = probed_with;
+    table->filters->probes[build.filter.get()] = probed_with;
+  }
+}
+
+int hash_join_filter(sqlite3_vtab_cursor *cur, int idx_num,
+                     const char *idx_str, int argc, sqlite3_value **argv) {
+  auto *cursor = (HashJoinCursor *)cur;
+  cursor->probe = idx_num == 1;
+
+  int n_build = cursor->probe ? argc - 1 : argc;
+  sqlite3_value **build_argv = cursor->probe ? argv + 1 : argv;
+
+  if (!hash_join_is_built(cursor->build, idx_str, n_build, build_argv)) {
+    int rc = hash_join_build(cursor, idx_str, n_build, build_argv);
+    if (rc != SQLITE_OK) {
+      return rc;
+    }
+  }
+
+  if (cursor->probe) {
+    if (cursor->build.filter != nullptr) {
+      hash_join_record_probe(cursor, argv[0]);
+    }
+    // Keys compare with INTEGER affinity, so '42' finds key 42.
+    cursor->found =
+        sqlite3_value_numeric_type(argv[0]) == SQLITE_INTEGER &&
+        cursor->build.index.find(sqlite3_value_int64(argv[0]), cursor->row);
+    cursor->eof = !cursor->found;
+  } else {
+    cursor->row = 0;
+    cursor->eof = cursor->build.keys.empty();
+  }
+  return SQLITE_OK;
+}
+
+int hash_join_next(sqlite3_vtab_cursor *cur) {
+  auto *cursor = (HashJoinCursor *)cur;
+  cursor->eof = cursor->probe || ++cursor->row >= cursor->build.keys.size();
+  return SQLITE_OK;
+}
+
+int hash_join_eof(sqlite3_vtab_cursor *cur) {
+  return ((HashJoinCursor *)cur)->eof;
+}
+
+int hash_join_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i) {
+  auto *cursor = (HashJoinCursor *)cur;
+  auto *table = (HashJoinTable *)cur->pVtab;
+  const ColumnVector &c = cursor->build.columns[i];
+  bool integer = table->columns.integer[i];
+  if (i == table->columns.rowid_alias) {
+    sqlite3_result_int64(ctx, cursor->build.keys[cursor->row]);
+  } else if ((integer ? c.ints.size() : c.offsets.size() - 1) <= cursor->row) {
+    // Not decoded: outside colUsed.
+    sqlite3_result_null(ctx);
+  } else {
+    c.result(ctx, integer, cursor->row);
+  }
+  return SQLITE_OK;
+}
+
+int hash_join_rowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid) {
+  auto *cursor = (HashJoinCursor *)cur;
+  *rowid = cursor->build.keys[cursor->row];
+  return SQLITE_OK;
+}
+
+sqlite3_module hash_join_module = {
+    0,                    // iVersion
+    hash_join_connect,    // xCreate
+    hash_join_connect,    // xConnect
+    hash_join_best_index, // xBestIndex
+    hash_join_disconnect, // xDisconnect
+    hash_join_disconnect, // xDestroy
+    hash_join_open,       // xOpen
+    hash_join_close,      // xClose
+    hash_join_filter,     // xFilter
+    hash_join_next,       // xNext
+    hash_join_eof,        // xEof
+    hash_join_column,     // xColumn
+    hash_join_rowid,      // xRowid
+    nullptr,              // xUpdate
+    nullptr,              // xBegin
+    nullptr,              // xSync
+    nullptr,              // xCommit
+    nullptr,              // xRollback
+    nullptr,              // xFindFunction
+    nullptr,              // xRename
+    nullptr,              // xSavepoint
+    nullptr,              // xRelease
+    nullptr,              // xRollbackTo
+    nullptr,              // xShadowName
+};
+
+int create_hash_join_module(sqlite3 *db,
+                            BloomFilterRegistry *filters = nullptr) {
+  return sqlite3_create_module(db, "hash_join", &hash_join_module, filters);
+}
+
+#endif // SQLITE_PERFORMANCE_SSB_HASH_JOIN_HPP
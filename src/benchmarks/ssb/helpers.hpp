@@ -1,10 +1,26 @@
 #ifndef SQLITE_PERFORMANCE_SSB_HELPERS_HPP
 #define SQLITE_PERFORMANCE_SSB_HELPERS_HPP
 
+#include <sys/stat.h>
+
+#include <algorithm>
 #include <array>
+#include <cerrno>
 #include <chrono>
+#include <cmath>
 #include <cxxopts.hpp>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+const std::array<std::string, 13> ssb_queries = {
+    "q1.1", "q1.2", "q1.3", "q2.1", "q2.2", "q2.3", "q3.1",
+    "q3.2", "q3.3", "q3.4", "q4.1", "q4.2", "q4.3"};
 
 template <typename F> double time(F &&f) {
   auto t0 = std::chrono::high_resolution_clock::now();
@@ -13,6 +29,99 @@ template <typename F> double time(F &&f) {
   return std::chrono::duration<double>(t1 - t0).count();
 }
 
+// The order in which stream s runs the queries. As in the TPC-H throughput
+// test, stream 0 runs them in the standard order and every other stream in a
+// permutation of its own, so concurrent streams rarely run the same query at
+// the same time. The permutation only depends on the output of mt19937, which
+// the standard fixes, so it is the same on every platform.
+std::vector<std::string> stream_queries(int stream) {
+  std::vector<std::string> queries(ssb_queries.begin(), ssb_queries.end());
+  if (stream > 0) {
+    std::mt19937 gen(stream);
+    for (size_t i = queries.size() - 1; i > 0; --i) {
+      std::swap(queries[i], queries[gen() % (i + 1)]);
+    }
+  }
+  return queries;
+}
+
+// The latencies of every query over all streams, and the time until the last
+// stream finished.
+struct StreamResults {
+  double elapsed = 0;
+  std::map<std::string, std::vector<double>> latencies;
+};
+
+// Runs n streams, stream s on its own thread calling run(s, query) for each
+// query of stream_queries(s).
+template <typename F> StreamResults run_streams(int n, F &&run) {
+  std::vector<std::vector<std::pair<std::string, double>>> latencies(n);
+  std::vector<std::string> errors(n);
+
+  StreamResults results;
+  results.elapsed = time([&] {
+    std::vector<std::thread> threads;
+    for (int s = 0; s < n; ++s) {
+      threads.emplace_back([&, s] {
+        try {
+          for (const std::string &query : stream_queries(s)) {
+            latencies[s].emplace_back(query, time([&] { run(s, query); }));
+          }
+        } catch (const std::exception &e) {
+          errors[s] = e.what();
+        }
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+  });
+
+  for (const std::string &error : errors) {
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+  }
+
+  for (const auto &stream : latencies) {
+    for (const auto &[query, latency] : stream) {
+      results.latencies[query].push_back(latency);
+    }
+  }
+  return results;
+}
+
+// Prints the throughput in queries per hour, then the minimum, median, 95th
+// percentile and maximum latency of each query (nearest rank).
+void print_streams(const StreamResults &results) {
+  size_t n_queries = 0;
+  for (const auto &[query, latencies] : results.latencies) {
+    n_queries += latencies.size();
+  }
+  std::cout << "queries_per_hour," << n_queries * 3600 / results.elapsed
+            << std::endl;
+
+  std::cout << "query,min,p50,p95,max" << std::endl;
+  for (const std::string &query : ssb_queries) {
+    std::vector<double> latencies = results.latencies.at(query);
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+      auto rank = (size_t)std::ceil(p * (double)latencies.size());
+      return latencies[std::max<size_t>(rank, 1) - 1];
+    };
+    std::cout << query << "," << latencies.front() << "," << percentile(0.5)
+              << "," << percentile(0.95) << "," << latencies.back()
+              << std::endl;
+  }
+}
+
+// Creates a directory that results are written to, if needed.
+void create_directory(const std::string &directory) {
+  if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    throw std::runtime_error("Cannot create " + directory);
+  }
+}
+
 cxxopts::Options ssb_options(const std::string &program,
                              const std::string &help_string = "") {
   cxxopts::Options options(program, help_string);
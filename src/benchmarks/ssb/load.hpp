@@ -0,0 +1,381 @@
+#ifndef SQLITE_PERFORMANCE_SSB_LOAD_HPP
+#define SQLITE_PERFORMANCE_SSB_LOAD_HPP
+
+// Bulk loading of the .tbl files of dbgen, in place of the .import commands
+// of sql/init/sqlite3.sql. A file is memory-mapped and cut into blocks at line
+// boundaries. Threads parse the blocks a few ahead of a single writer, which
+// binds the fields to one prepared INSERT in file order. dbgen writes every
+// table in primary key order, so each insert appends to the B-trees. Foreign
+// keys are only checked once all tables are loaded.
+//
+// The values are the ones .import stores: a field of an INTEGER column that
+// is an integer is bound as one, and every other field as text, to which the
+// column affinity applies as usual.
+//
+// The binary column files of dbgen -D (colfile.hpp) are loaded the same way,
+// except that there is nothing to parse: the writer binds the values straight
+// from the mapped columns.
+
+#include "colfile.hpp"
+#include "helpers.hpp"
+#include "sqlite3.h"
+#include "vtab.hpp"
+
+#include <cstring>
+#include <deque>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A field of a .tbl file. text points into the mapped file.
+struct TblField {
+  const char *text;
+  int size;
+  bool integer;
+  sqlite3_int64 value;
+};
+
+// Cuts data into blocks of about block_size bytes, each ending after a
+// newline or at the end of the data.
+std::vector<std::pair<const char *, const char *>>
+tbl_blocks(const char *data, size_t size, size_t block_size) {
+  std::vector<std::pair<const char *, const char *>> blocks;
+  const char *end = data + size;
+  const char *begin = data;
+  while (begin < end) {
+    const char *split =
+        (size_t)(end - begin) > block_size ? begin + block_size : end;
+    while (split < end && split[-1] != '\n') {
+      ++split;
+    }
+    blocks.emplace_back(begin, split);
+    begin = split;
+  }
+  return blocks;
+}
+
+// Parses the integer in [p, p + size) as SQLite would convert text to an
+// INTEGER column: optional sign, then 1 to 18 digits (longer numbers are left
+// as text, like any field that is not an integer).
+bool tbl_integer(const char *p, int size, sqlite3_int64 &value) {
+  int i = size > 0 && p[0] == '-' ? 1 : 0;
+  if (size == i || size - i > 18) {
+    return false;
+  }
+  sqlite3_int64 v = 0;
+  for (; i < size; ++i) {
+    if (p[i] < '0' || p[i] > '9') {
+      return false;
+    }
+    v = v * 10 + (p[i] - '0');
+  }
+  value = p[0] == '-' ? -v : v;
+  return true;
+}
+
+// Splits the lines of [begin, end) into the fields of the columns. A line
+// may end with a separator, as the .tbl files of TPC-H do.
+std::vector<TblField> tbl_parse(const char *begin, const char *end,
+                                const VtabColumns &columns) {
+  size_t n_columns = columns.names.size();
+  std::vector<TblField> fields;
+  fields.reserve((size_t)(end - begin) / 6);
+
+  for (const char *p = begin; p < end;) {
+    auto *line_end = (const char *)memchr(p, '\n', (size_t)(end - p));
+    if (line_end == nullptr) {
+      line_end = end;
+    }
+    const char *stop = line_end > p && line_end[-1] == '\r' ? line_end - 1
+                                                              : line_end;
+
+    size_t first = fields.size();
+    for (const char *field = p;;) {
+      auto *separator =
+          (const char *)memchr(field, '|', (size_t)(stop - field));
+      if (separator == nullptr) {
+        separator = stop;
+      }
+      size_t column = fields.size() - first;
+      TblField value{field, (int)(separator - field), false, 0};
+      if (column < n_columns && columns.integer[column]) {
+        value.integer = tbl_integer(field, value.size, value.value);
+      }
+      fields.push_back(value);
+      if (separator == stop) {
+        break;
+      }
+      field = separator + 1;
+    }
+
+    if (fields.size() - first == n_columns + 1 && fields.back().size == 0) {
+      fields.pop_back();
+    }
+    if (fields.size() - first != n_columns) {
+      throw std::runtime_error("Expected " + std::to_string(n_columns) +
+                               " fields in line: " + std::string(p, stop));
+    }
+    p = line_end + 1;
+  }
+  return fields;
+}
+
+// The columns of main.<table>. Unlike the virtual tables, the load takes
+// columns of any type: only the fields of INTEGER columns are bound as
+// integers, and the affinity of the others converts the text.
+VtabColumns load_columns(sqlite3 *db, const std::string &table) {
+  sqlite3_stmt *stmt;
+  if (sqlite3_prepare_v2(
+          db, "SELECT name, upper(type) FROM pragma_table_info(?1, 'main')",
+          -1, &stmt, nullptr) != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errmsg(db));
+  }
+  VtabColumns columns;
+  sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_TRANSIENT);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    std::string type = (const char *)sqlite3_column_text(stmt, 1);
+    columns.names.emplace_back((const char *)sqlite3_column_text(stmt, 0));
+    columns.integer.push_back(type.find("INT") != std::string::npos);
+  }
+  sqlite3_finalize(stmt);
+  if (columns.names.empty()) {
+    throw std::runtime_error("load: no such table main." + table);
+  }
+  return columns;
+}
+
+// An INSERT of a row of n_columns values into main.<table>.
+sqlite3_stmt *load_insert(sqlite3 *db, const std::string &table,
+                          size_t n_columns) {
+  std::string sql = "INSERT INTO main." + vtab_quote(table) + " VALUES (";
+  for (size_t i = 0; i < n_columns; ++i) {
+    sql += i > 0 ? ", ?" : "?";
+  }
+  sql += ")";
+  sqlite3_stmt *stmt;
+  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errmsg(db));
+  }
+  return stmt;
+}
+
+// Loads path into main.<table> with n_threads parsing threads. The caller
+// holds the transaction.
+void load_tbl(sqlite3 *db, const std::string &table, const std::string &path,
+              int n_threads) {
+  VtabColumns columns = load_columns(db, table);
+  size_t n_columns = columns.names.size();
+  sqlite3_stmt *stmt = load_insert(db, table, n_columns);
+
+  MappedFile file(path);
+  auto blocks = tbl_blocks(file.data(), file.size(), 4 << 20);
+
+  // Up to n_threads blocks are parsed ahead of the writer, each on a thread
+  // of its own.
+  std::deque<std::future<std::vector<TblField>>> parsed;
+  size_t next = 0;
+  auto parse_next = [&] {
+    const auto &[begin, end] = blocks[next++];
+    parsed.push_back(std::async(std::launch::async, [&, begin = begin,
+                                                     end = end] {
+      return tbl_parse(begin, end, columns);
+    }));
+  };
+  while (next < blocks.size() && parsed.size() < (size_t)n_threads) {
+    parse_next();
+  }
+
+  std::string error;
+  while (!parsed.empty()) {
+    std::vector<TblField> fields;
+    try {
+      fields = parsed.front().get();
+    } catch (const std::exception &e) {
+      error = e.what();
+    }
+    parsed.pop_front();
+    if (!error.empty()) {
+      break;
+    }
+    if (next < blocks.size()) {
+      parse_next();
+    }
+
+    // The fields point into the mapping, which outlives the statement.
+    for (size_t row = 0; row < fields.size(); row += n_columns) {
+      for (size_t i = 0; i < n_columns; ++i) {
+        const TblField &field = fields[row + i];
+        if (field.integer) {
+          sqlite3_bind_int64(stmt, (int)i + 1, field.value);
+        } else {
+          sqlite3_bind_text(stmt, (int)i + 1, field.text, field.size,
+                            SQLITE_STATIC);
+        }
+      }
+      if (sqlite3_step(stmt) != SQLITE_DONE) {
+        error = sqlite3_errmsg(db);
+        break;
+      }
+      sqlite3_reset(stmt);
+    }
+    if (!error.empty()) {
+      break;
+    }
+  }
+
+  // The remaining parsers still read the mapping and the columns.
+  for (auto &future : parsed) {
+    future.wait();
+  }
+  sqlite3_finalize(stmt);
+  if (!error.empty()) {
+    throw std::runtime_error(table + ": " + error);
+  }
+}
+
+// Loads the column files of dbgen -D for table into main.<table>. The values
+// are bound from the mappings as they are; the integers of dbgen are bound as
+// integers and its strings as text, to which the column affinity applies as
+// for .import. The caller holds the transaction.
+void load_col(sqlite3 *db, const std::string &table) {
+  size_t n_columns = load_columns(db, table).names.size();
+  ColTable file(table);
+  if (file.n_columns() != n_columns) {
+    throw std::runtime_error(table + ": expected " +
+                             std::to_string(n_columns) + " column files, got " +
+                             std::to_string(file.n_columns()));
+  }
+  std::vector<bool> integer(n_columns);
+  for (size_t i = 0; i < n_columns; ++i) {
+    integer[i] = file.integer(i);
+  }
+
+  sqlite3_stmt *stmt = load_insert(db, table, n_columns);
+  std::string error;
+  try {
+    for (uint64_t row = 0; row < file.rows(); ++row) {
+      for (size_t i = 0; i < n_columns; ++i) {
+        if (integer[i]) {
+          sqlite3_bind_int64(stmt, (int)i + 1, file.next_int(i));
+        } else {
+          std::string_view value = file.next_str(i);
+          sqlite3_bind_text(stmt, (int)i + 1, value.data(), (int)value.size(),
+                            SQLITE_STATIC);
+        }
+      }
+      if (sqlite3_step(stmt) != SQLITE_DONE) {
+        error = sqlite3_errmsg(db);
+        break;
+      }
+      sqlite3_reset(stmt);
+    }
+  } catch (const std::exception &e) {
+    error = e.what();
+  }
+  sqlite3_finalize(stmt);
+  if (!error.empty()) {
+    throw std::runtime_error(table + ": " + error);
+  }
+}
+
+// Checks the foreign keys and commits the load.
+void load_check(sqlite3 *db) {
+  sqlite3_stmt *stmt;
+  if (sqlite3_prepare_v2(db, "PRAGMA main.foreign_key_check", -1, &stmt,
+                         nullptr) != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errmsg(db));
+  }
+  int rc = sqlite3_step(stmt);
+  std::string violation;
+  if (rc == SQLITE_ROW) {
+    violation = std::string((const char *)sqlite3_column_text(stmt, 0)) +
+                " row " + std::to_string(sqlite3_column_int64(stmt, 1)) +
+                " references a missing row of " +
+                (const char *)sqlite3_column_text(stmt, 2);
+  }
+  sqlite3_finalize(stmt);
+  if (rc == SQLITE_ROW) {
+    throw std::runtime_error("Foreign key violation: " + violation);
+  }
+  if (rc != SQLITE_DONE ||
+      sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errmsg(db));
+  }
+}
+
+// The statements of a script of the sqlite3 shell, without its dot-commands.
+std::string load_statements(const std::string &script) {
+  std::istringstream lines(script);
+  std::string statements;
+  for (std::string line; std::getline(lines, line);) {
+    if (line.empty() || line[0] != '.') {
+      statements += line + "\n";
+    }
+  }
+  return statements;
+}
+
+// Runs schema, then loads <table>.tbl (or, with col, the column files of
+// dbgen -D) into each of tables in a single transaction and checks the
+// foreign keys. Returns the time of each table, followed by the time of the
+// foreign key check.
+std::vector<double> load_tables(sqlite3 *db, const std::string &schema,
+                                const std::vector<std::string> &tables,
+                                int n_threads, bool col) {
+  // Nothing is read before the load is complete, so a crash only loses a
+  // database that has to be loaded again anyway.
+  std::string sql = "PRAGMA journal_mode=OFF; PRAGMA synchronous=OFF; " +
+                    schema + "; BEGIN";
+  char *message = nullptr;
+  if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &message) != SQLITE_OK) {
+    std::string error = message != nullptr ? message : sqlite3_errmsg(db);
+    sqlite3_free(message);
+    throw std::runtime_error(error);
+  }
+
+  std::vector<double> times;
+  for (const std::string &table : tables) {
+    times.push_back(time([&] {
+      if (col) {
+        load_col(db, table);
+      } else {
+        load_tbl(db, table, table + ".tbl", n_threads);
+      }
+    }));
+  }
+  times.push_back(time([&] { load_check(db); }));
+  return times;
+}
+
+// Rewrites main.<table> in the order of column, so that its rowids follow
+// the column, as a zone map needs. The rows are copied out to a temporary
+// table in that order and inserted back, which numbers them from 1 again.
+void load_cluster(sqlite3 *db, const std::string &table,
+                  const std::string &column) {
+  std::string quoted = "main." + vtab_quote(table);
+  std::string sql = "BEGIN; CREATE TEMP TABLE load_cluster AS SELECT * FROM " +
+                    quoted + " ORDER BY " + vtab_quote(column) +
+                    ", rowid; DELETE FROM " + quoted + "; INSERT INTO " +
+                    quoted +
+                    " SELECT * FROM temp.load_cluster ORDER BY rowid; "
+                    "DROP TABLE temp.load_cluster; COMMIT";
+  char *message = nullptr;
+  if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &message) != SQLITE_OK) {
+    std::string error = message != nullptr ? message : sqlite3_errmsg(db);
+    sqlite3_free(message);
+    sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+    throw std::runtime_error(table + ": " + error);
+  }
+}
+
+std::vector<double> load_ssb(sqlite3 *db, const std::string &schema,
+                             int n_threads, bool col) {
+  return load_tables(db, schema,
+                     {"part", "supplier", "customer", "date", "lineorder"},
+                     n_threads, col);
+}
+
+#endif // SQLITE_PERFORMANCE_SSB_LOAD_HPP
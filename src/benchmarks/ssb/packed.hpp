@@ -0,0 +1,667 @@
+#ifndef SQLITE_PERFORMANCE_SSB_PACKED_HPP
+#define SQLITE_PERFORMANCE_SSB_PACKED_HPP
+
+// Packed records: a copy of a rowid table of the main schema in which each
+// row is a single BLOB that keeps its INTEGER columns at fixed byte offsets,
+//
+//   <table>_packed(rowid INTEGER PRIMARY KEY, record BLOB)
+//   <table>_packed_layout(name TEXT, width INTEGER, source_rows INTEGER)
+//
+// with one layout row per column, in column order, each with the number of
+// rows of the table that the copy was written from. A record starts with the
+// INTEGER columns, each in the fewest bytes (1, 2, 4 or 8) that hold every
+// value of the column, followed by a table of uint16_t end offsets of the
+// TEXT columns (width 0) and then their bytes. Any column is decoded with one
+// read at an offset known from the layout, instead of a walk over the varint
+// header of SQLite's record format, so its cost does not depend on the
+// column's position.
+//
+//   CREATE VIRTUAL TABLE temp.lineorder USING packed(lineorder);
+//
+// scans the copy through a statement that reads only the record, and
+// evaluates the constant constraints on the decoded values as batch_scan
+// does.
+
+#include "batch_scan.hpp"
+#include "sqlite3.h"
+#include "vtab.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct PackedLayout {
+  // Width of each column in bytes, 0 for TEXT.
+  std::vector<int> widths;
+  // Offset of each INTEGER column, and index of each TEXT column among them.
+  std::vector<int> offsets;
+  int n_text = 0;
+  // Size of the INTEGER columns and the end offsets.
+  int header_size = 0;
+
+  void assign(const std::vector<int> &column_widths) {
+    widths = column_widths;
+    offsets.clear();
+    n_text = 0;
+    int offset = 0;
+    for (int width : widths) {
+      offsets.push_back(width > 0 ? offset : n_text++);
+      offset += width;
+    }
+    header_size = offset + 2 * n_text;
+  }
+};
+
+std::string packed_table(const std::string &table) {
+  return table + "_packed";
+}
+
+std::string packed_layout_table(const std::string &table) {
+  return table + "_packed_layout";
+}
+
+// The fewest bytes that hold every value in [min, max].
+int packed_width(sqlite3_int64 min, sqlite3_int64 max) {
+  if (min >= INT8_MIN && max <= INT8_MAX) {
+    return 1;
+  } else if (min >= INT16_MIN && max <= INT16_MAX) {
+    return 2;
+  } else if (min >= INT32_MIN && max <= INT32_MAX) {
+    return 4;
+  }
+  return 8;
+}
+
+sqlite3_int64 packed_int(const unsigned char *p, int width) {
+  switch (width) {
+  case 1:
+    return (int8_t)*p;
+  case 2: {
+    int16_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+  case 4: {
+    int32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+  default: {
+    sqlite3_int64 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+  }
+}
+
+// The bytes of TEXT column j, counted among the TEXT columns, of a record.
+const char *packed_text(const unsigned char *record, const PackedLayout &layout,
+                        int j, size_t &size) {
+  const unsigned char *ends =
+      record + layout.header_size - 2 * layout.n_text;
+  uint16_t begin = (uint16_t)layout.header_size;
+  uint16_t end;
+  if (j > 0) {
+    memcpy(&begin, ends + 2 * (j - 1), sizeof(begin));
+  }
+  memcpy(&end, ends + 2 * j, sizeof(end));
+  size = end - begin;
+  return (const char *)record + begin;
+}
+
+template <typename T> void packed_store(char *p, sqlite3_int64 value) {
+  auto narrow = (T)value;
+  memcpy(p, &narrow, sizeof(narrow));
+}
+
+// Encodes one row of stmt, whose columns from first_column on follow the
+// layout, into record. Returns false if the record is too long for the end
+// offsets.
+bool packed_encode(const PackedLayout &layout, sqlite3_stmt *stmt,
+                   int first_column, std::string &record) {
+  record.assign((size_t)layout.header_size, '\0');
+  int n_text = 0;
+  for (size_t i = 0; i < layout.widths.size(); ++i) {
+    int column = first_column + (int)i;
+    int width = layout.widths[i];
+    if (width > 0) {
+      char *p = &record[(size_t)layout.offsets[i]];
+      sqlite3_int64 value = sqlite3_column_int64(stmt, column);
+      switch (width) {
+      case 1:
+        packed_store<int8_t>(p, value);
+        break;
+      case 2:
+        packed_store<int16_t>(p, value);
+        break;
+      case 4:
+        packed_store<int32_t>(p, value);
+        break;
+      default:
+        packed_store<sqlite3_int64>(p, value);
+      }
+    } else {
+      record.append((const char *)sqlite3_column_text(stmt, column),
+                    (size_t)sqlite3_column_bytes(stmt, column));
+      if (record.size() > UINT16_MAX) {
+        return false;
+      }
+      auto end = (uint16_t)record.size();
+      size_t at = layout.header_size - 2 * (layout.n_text - n_text++);
+      memcpy(&record[at], &end, sizeof(end));
+    }
+  }
+  return true;
+}
+
+// The integer in the first column of the first row of sql, or -1 if sql
+// returns no row or fails.
+sqlite3_int64 packed_query_int(sqlite3 *db, const std::string &sql) {
+  sqlite3_stmt *stmt;
+  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    return -1;
+  }
+  sqlite3_int64 value =
+      sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : -1;
+  sqlite3_finalize(stmt);
+  return value;
+}
+
+// Writes the packed copy of main.<table>, unless there is one written from
+// as many rows as the table holds. Any other copy, missing its row count or
+// left over from a table that has been loaded again since, is dropped and
+// written again. Every value must have the declared type of its column.
+int create_packed_table(sqlite3 *db, const std::string &table,
+                        char **pz_err) {
+  std::string packed = "main." + vtab_quote(packed_table(table));
+  std::string layout_table = "main." + vtab_quote(packed_layout_table(table));
+
+  sqlite3_int64 rows =
+      packed_query_int(db, "SELECT count(*) FROM main." + vtab_quote(table));
+  if (rows < 0) {
+    *pz_err = sqlite3_mprintf("packed: %s", sqlite3_errmsg(db));
+    return SQLITE_ERROR;
+  }
+  if (packed_query_int(db, "SELECT source_rows FROM " + layout_table +
+                               " LIMIT 1") == rows) {
+    return SQLITE_OK;
+  }
+
+  VtabColumns columns;
+  int rc = vtab_columns(db, "packed", table, columns, pz_err);
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+
+  // The bounds of every column, and the number of values of another type.
+  std::ostringstream select;
+  select << "SELECT ";
+  for (size_t i = 0; i < columns.names.size(); ++i) {
+    std::string column = vtab_quote(columns.names[i]);
+    const char *type = columns.integer[i] ? "integer" : "text";
+    select << (i > 0 ? ", " : "") << "min(" << column << "), max(" << column
+           << "), count(*) FILTER (WHERE typeof(" << column << ") != '" << type
+           << "')";
+  }
+  select << " FROM main." << vtab_quote(table);
+
+  std::vector<int> widths;
+  sqlite3_stmt *stmt;
+  rc = sqlite3_prepare_v2(db, select.str().c_str(), -1, &stmt, nullptr);
+  if (rc == SQLITE_OK && sqlite3_step(stmt) != SQLITE_ROW) {
+    rc = sqlite3_errcode(db);
+  }
+  if (rc == SQLITE_OK) {
+    for (size_t i = 0; i < columns.names.size() && rc == SQLITE_OK; ++i) {
+      int column = 3 * (int)i;
+      if (sqlite3_column_int64(stmt, column + 2) != 0) {
+        *pz_err = sqlite3_mprintf(
+            "packed: %s.%s holds a value of unexpected type", table.c_str(),
+            columns.names[i].c_str());
+        rc = SQLITE_ERROR;
+      } else {
+        widths.push_back(columns.integer[i]
+                             ? packed_width(
+                                   sqlite3_column_int64(stmt, column),
+                                   sqlite3_column_int64(stmt, column + 1))
+                             : 0);
+      }
+    }
+  }
+  sqlite3_finalize(stmt);
+  if (rc != SQLITE_OK) {
+    if (*pz_err == nullptr) {
+      *pz_err = sqlite3_mprintf("packed: %s", sqlite3_errmsg(db));
+    }
+    return rc;
+  }
+  PackedLayout layout;
+  layout.assign(widths);
+
+  std::ostringstream sql;
+  sql << "BEGIN; DROP TABLE IF EXISTS " << packed
+      << "; DROP TABLE IF EXISTS " << layout_table << "; CREATE TABLE "
+      << packed << "(rowid INTEGER PRIMARY KEY, record BLOB); CREATE TABLE "
+      << layout_table << "(name TEXT, width INTEGER, source_rows INTEGER);";
+  for (size_t i = 0; i < columns.names.size(); ++i) {
+    char *name = sqlite3_mprintf("%Q", columns.names[i].c_str());
+    sql << "INSERT INTO " << layout_table << " VALUES (" << name << ", "
+        << widths[i] << ", " << rows << ");";
+    sqlite3_free(name);
+  }
+  sqlite3_stmt *insert = nullptr;
+  std::ostringstream scan;
+  scan << "SELECT rowid";
+  for (const std::string &name : columns.names) {
+    scan << ", " << vtab_quote(name);
+  }
+  scan << " FROM main." << vtab_quote(table);
+  rc = sqlite3_exec(db, sql.str().c_str(), nullptr, nullptr, nullptr);
+  if (rc == SQLITE_OK) {
+    rc = sqlite3_prepare_v2(db, scan.str().c_str(), -1, &stmt, nullptr);
+  }
+  if (rc == SQLITE_OK) {
+    std::string insert_sql = "INSERT INTO " + packed + " VALUES (?1, ?2)";
+    rc = sqlite3_prepare_v2(db, insert_sql.c_str(), -1, &insert, nullptr);
+  }
+
+  std::string record;
+  while (rc == SQLITE_OK && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    if (!packed_encode(layout, stmt, 1, record)) {
+      *pz_err = sqlite3_mprintf("packed: a row of %s is too long",
+                                table.c_str());
+      rc = SQLITE_TOOBIG;
+      break;
+    }
+    sqlite3_bind_int64(insert, 1, sqlite3_column_int64(stmt, 0));
+    sqlite3_bind_blob(insert, 2, record.data(), (int)record.size(),
+                      SQLITE_STATIC);
+    rc = sqlite3_step(insert);
+    rc = rc == SQLITE_DONE ? sqlite3_reset(insert) : rc;
+  }
+  if (rc == SQLITE_DONE) {
+    rc = SQLITE_OK;
+  }
+  if (rc != SQLITE_OK && *pz_err == nullptr) {
+    *pz_err = sqlite3_mprintf("packed: %s", sqlite3_errmsg(db));
+  }
+  sqlite3_finalize(stmt);
+  sqlite3_finalize(insert);
+  sqlite3_exec(db, rc == SQLITE_OK ? "COMMIT" : "ROLLBACK", nullptr, nullptr,
+               nullptr);
+  return rc;
+}
+
+struct PackedTable {
+  sqlite3_vtab base;
+  sqlite3 *db;
+  std::string name;
+  VtabColumns columns;
+  PackedLayout layout;
+  double n_rows;
+};
+
+// Records are read a batch at a time, as in batch_scan, so that the
+// underlying statement is not stepped once per row.
+struct PackedCursor {
+  sqlite3_vtab_cursor base;
+  sqlite3_stmt *stmt = nullptr;
+  std::vector<BatchConstraint> constraints;
+  std::vector<sqlite3_int64> rowids;
+  ColumnVector records;
+  // Rows of the batch that satisfy all constraints, in scan order.
+  std::vector<uint16_t> selection;
+  size_t selected = 0;
+  size_t pos = 0;
+  const unsigned char *record = nullptr;
+  bool done = true;
+  bool eof = true;
+};
+
+int packed_read_layout(PackedTable *table, char **pz_err) {
+  std::string sql = "SELECT name, width FROM main." +
+                    vtab_quote(packed_layout_table(table->name)) +
+                    " ORDER BY rowid";
+  sqlite3_stmt *stmt;
+  int rc = sqlite3_prepare_v2(table->db, sql.c_str(), -1, &stmt, nullptr);
+  if (rc != SQLITE_OK) {
+    *pz_err = sqlite3_mprintf("packed: %s", sqlite3_errmsg(table->db));
+    return rc;
+  }
+
+  std::vector<int> widths;
+  bool matches = true;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    size_t i = widths.size();
+    auto *name = (const char *)sqlite3_column_text(stmt, 0);
+    int width = sqlite3_column_int(stmt, 1);
+    matches = matches && i < table->columns.names.size() &&
+              table->columns.names[i] == name &&
+              (table->columns.integer[i]
+                   ? width == 1 || width == 2 || width == 4 || width == 8
+                   : width == 0);
+    widths.push_back(width);
+  }
+  sqlite3_finalize(stmt);
+
+  if (!matches || widths.size() != table->columns.names.size()) {
+    *pz_err = sqlite3_mprintf("packed: the layout of %s does not match it",
+                              table->name.c_str());
+    return SQLITE_ERROR;
+  }
+  table->layout.assign(widths);
+  return SQLITE_OK;
+}
+
+int packed_connect(sqlite3 *db, void *, int argc, const char *const *argv,
+                   sqlite3_vtab **pp_vtab, char **pz_err) {
+  if (argc != 4) {
+    *pz_err = sqlite3_mprintf("packed: expected one argument, the table");
+    return SQLITE_ERROR;
+  }
+
+  auto *table = new PackedTable();
+  table->db = db;
+  table->name = vtab_dequote(argv[3]);
+
+  int rc = vtab_columns(db, "packed", table->name, table->columns, pz_err);
+  if (rc == SQLITE_OK) {
+    rc = packed_read_layout(table, pz_err);
+  }
+  if (rc == SQLITE_OK) {
+    rc = vtab_declare(db, table->columns);
+  }
+  if (rc != SQLITE_OK) {
+    delete table;
+    return rc;
+  }
+  table->n_rows = vtab_row_estimate(db, table->name);
+
+  *pp_vtab = &table->base;
+  return SQLITE_OK;
+}
+
+int packed_disconnect(sqlite3_vtab *vtab) {
+  delete (PackedTable *)vtab;
+  return SQLITE_OK;
+}
+
+// The plan is encoded in idxStr as one "column op" pair per argv entry.
+int packed_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info) {
+  auto *table = (PackedTable *)vtab;
+
+  std::ostringstream plan;
+  double rows = table->n_rows;
+  double cost = table->n_rows;
+  int argv_index = 0;
+  for (int i = 0; i < info->nConstraint; ++i) {
+    const auto &constraint = info->aConstraint[i];
+    if (!vtab_constant_constraint(info, i, table->columns) ||
+        (constraint.iColumn < 0 &&
+         constraint.op == SQLITE_INDEX_CONSTRAINT_NE)) {
+      continue;
+    }
+
+    info->aConstraintUsage[i].argvIndex = ++argv_index;
+    info->aConstraintUsage[i].omit = 1;
+    plan << constraint.iColumn << " " << (int)constraint.op << " ";
+
+    if (constraint.iColumn < 0) {
+      if (constraint.op == SQLITE_INDEX_CONSTRAINT_EQ) {
+        rows = 1;
+        cost = 1;
+        info->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
+      } else {
+        rows /= 2;
+        cost /= 2;
+      }
+    } else {
+      rows /= constraint.op == SQLITE_INDEX_CONSTRAINT_EQ ? 10 : 3;
+    }
+  }
+
+  info->idxStr = sqlite3_mprintf("%s", plan.str().c_str());
+  info->needToFreeIdxStr = 1;
+  info->estimatedRows = (sqlite3_int64)std::max(1.0, rows);
+  info->estimatedCost = std::max(1.0, cost);
+  return SQLITE_OK;
+}
+
+int packed_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **pp_cursor) {
+  auto *table = (PackedTable *)vtab;
+  auto *cursor = new PackedCursor();
+  std::string sql = "SELECT 1 FROM main." +
+                    vtab_quote(packed_table(table->name)) +
+                    " WHERE rowid BETWEEN ?1 AND ?2 AND"
+                    " packed_append(?3, rowid, record)";
+  int rc = sqlite3_prepare_v2(table->db, sql.c_str(), -1, &cursor->stmt,
+                              nullptr);
+  if (rc != SQLITE_OK) {
+    table->base.zErrMsg =
+        sqlite3_mprintf("packed: %s", sqlite3_errmsg(table->db));
+    delete cursor;
+    return rc;
+  }
+  cursor->selection.resize(batch_size);
+  *pp_cursor = &cursor->base;
+  return SQLITE_OK;
+}
+
+int packed_close(sqlite3_vtab_cursor *cur) {
+  auto *cursor = (PackedCursor *)cur;
+  sqlite3_finalize(cursor->stmt);
+  delete cursor;
+  return SQLITE_OK;
+}
+
+// Called by the underlying statement for every record, like
+// batch_scan_append. Records are validated as they are copied: the end
+// offsets must be increasing and within the record.
+void packed_append(sqlite3_context *ctx, int, sqlite3_value **argv) {
+  auto *cursor = (PackedCursor *)sqlite3_value_pointer(argv[0], "packed");
+  if (cursor == nullptr) {
+    sqlite3_result_error(ctx, "packed_append: no cursor", -1);
+    return;
+  }
+  const PackedLayout &layout = ((PackedTable *)cursor->base.pVtab)->layout;
+
+  auto *record = (const unsigned char *)sqlite3_value_blob(argv[2]);
+  int size = sqlite3_value_bytes(argv[2]);
+  bool valid = size >= layout.header_size;
+  uint16_t previous = (uint16_t)layout.header_size;
+  for (int j = 0; j < layout.n_text && valid; ++j) {
+    uint16_t end;
+    memcpy(&end, record + layout.header_size - 2 * (layout.n_text - j),
+           sizeof(end));
+    valid = end >= previous && end <= size;
+    previous = end;
+  }
+  if (!valid) {
+    char *message = sqlite3_mprintf("packed: malformed record %lld",
+                                    sqlite3_value_int64(argv[1]));
+    sqlite3_result_error(ctx, message, -1);
+    sqlite3_free(message);
+    return;
+  }
+
+  cursor->rowids.push_back(sqlite3_value_int64(argv[1]));
+  cursor->records.append_text((const char *)record, (size_t)size);
+  sqlite3_result_int(ctx, cursor->rowids.size() == batch_size);
+}
+
+// Whether the record satisfies all constraints.
+bool packed_match(const PackedCursor *cursor, const PackedLayout &layout,
+                  const unsigned char *record) {
+  for (const BatchConstraint &constraint : cursor->constraints) {
+    int column = constraint.column;
+    int cmp;
+    if (column < 0) {
+      continue;
+    } else if (layout.widths[column] > 0) {
+      sqlite3_int64 value =
+          packed_int(record + layout.offsets[column], layout.widths[column]);
+      cmp = (value > constraint.int_value) - (value < constraint.int_value);
+    } else {
+      size_t size;
+      const char *text =
+          packed_text(record, layout, layout.offsets[column], size);
+      const std::string &rhs = constraint.text_value;
+      cmp = memcmp(text, rhs.data(), std::min(size, rhs.size()));
+      cmp = cmp != 0 ? cmp : (size > rhs.size()) - (size < rhs.size());
+    }
+    if (!vtab_satisfies(constraint.op, cmp)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Reads the next batch of records in which some record satisfies the
+// constraints.
+int packed_fill(PackedCursor *cursor) {
+  auto *table = (PackedTable *)cursor->base.pVtab;
+  cursor->pos = 0;
+
+  size_t n;
+  do {
+    cursor->rowids.clear();
+    cursor->records.clear();
+    if (!cursor->done) {
+      int rc = sqlite3_step(cursor->stmt);
+      if (rc == SQLITE_DONE) {
+        cursor->done = true;
+      } else if (rc != SQLITE_ROW) {
+        table->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(table->db));
+        return rc;
+      }
+    }
+
+    n = cursor->rowids.size();
+    const auto *chars = (const unsigned char *)cursor->records.chars.data();
+    const uint32_t *offsets = cursor->records.offsets.data();
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+      cursor->selection[k] = (uint16_t)i;
+      k += packed_match(cursor, table->layout, chars + offsets[i]);
+    }
+    cursor->selected = k;
+  } while (n > 0 && cursor->selected == 0);
+
+  cursor->eof = n == 0;
+  if (!cursor->eof) {
+    cursor->record = (const unsigned char *)cursor->records.chars.data() +
+                     cursor->records.offsets[cursor->selection[0]];
+  }
+  return SQLITE_OK;
+}
+
+int packed_filter(sqlite3_vtab_cursor *cur, int, const char *idx_str,
+                  int argc, sqlite3_value **argv) {
+  auto *cursor = (PackedCursor *)cur;
+  auto *table = (PackedTable *)cur->pVtab;
+
+  std::istringstream plan(idx_str);
+  cursor->constraints.clear();
+  sqlite3_int64 min_rowid = std::numeric_limits<sqlite3_int64>::min();
+  sqlite3_int64 max_rowid = std::numeric_limits<sqlite3_int64>::max();
+  for (int i = 0; i < argc; ++i) {
+    BatchConstraint constraint;
+    int op;
+    plan >> constraint.column >> op;
+    constraint.op = (unsigned char)op;
+    if (constraint.column >= 0 && !table->columns.integer[constraint.column]) {
+      constraint.text_value.assign(
+          (const char *)sqlite3_value_text(argv[i]),
+          (size_t)sqlite3_value_bytes(argv[i]));
+    } else {
+      constraint.int_value = sqlite3_value_int64(argv[i]);
+    }
+    if (constraint.column < 0) {
+      vtab_rowid_range(constraint.op, constraint.int_value, min_rowid,
+                       max_rowid);
+    }
+    cursor->constraints.push_back(std::move(constraint));
+  }
+
+  sqlite3_reset(cursor->stmt);
+  sqlite3_bind_int64(cursor->stmt, 1, min_rowid);
+  sqlite3_bind_int64(cursor->stmt, 2, max_rowid);
+  sqlite3_bind_pointer(cursor->stmt, 3, cursor, "packed", nullptr);
+  cursor->done = false;
+  return packed_fill(cursor);
+}
+
+int packed_next(sqlite3_vtab_cursor *cur) {
+  auto *cursor = (PackedCursor *)cur;
+  if (++cursor->pos >= cursor->selected) {
+    return packed_fill(cursor);
+  }
+  cursor->record = (const unsigned char *)cursor->records.chars.data() +
+                   cursor->records.offsets[cursor->selection[cursor->pos]];
+  return SQLITE_OK;
+}
+
+int packed_eof(sqlite3_vtab_cursor *cur) { return ((PackedCursor *)cur)->eof; }
+
+int packed_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i) {
+  auto *cursor = (PackedCursor *)cur;
+  const PackedLayout &layout = ((PackedTable *)cur->pVtab)->layout;
+  if (layout.widths[i] > 0) {
+    sqlite3_result_int64(
+        ctx, packed_int(cursor->record + layout.offsets[i], layout.widths[i]));
+  } else {
+    size_t size;
+    const char *text =
+        packed_text(cursor->record, layout, layout.offsets[i], size);
+    sqlite3_result_text(ctx, text, (int)size, SQLITE_TRANSIENT);
+  }
+  return SQLITE_OK;
+}
+
+int packed_rowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid) {
+  auto *cursor = (PackedCursor *)cur;
+  *rowid = cursor->rowids[cursor->selection[cursor->pos]];
+  return SQLITE_OK;
+}
+
+sqlite3_module packed_module = {
+    0,                 // iVersion
+    packed_connect,    // xCreate
+    packed_connect,    // xConnect
+    packed_best_index, // xBestIndex
+    packed_disconnect, // xDisconnect
+    packed_disconnect, // xDestroy
+    packed_open,       // xOpen
+    packed_close,      // xClose
+    packed_filter,     // xFilter
+    packed_next,       // xNext
+    packed_eof,        // xEof
+    packed_column,     // xColumn
+    packed_rowid,      // xRowid
+    nullptr,           // xUpdate
+    nullptr,           // xBegin
+    nullptr,           // xSync
+    nullptr,           // xCommit
+    nullptr,           // xRollback
+    nullptr,           // xFindFunction
+    nullptr,           // xRename
+    nullptr,           // xSavepoint
+    nullptr,           // xRelease
+    nullptr,           // xRollbackTo
+    nullptr,           // xShadowName
+};
+
+int create_packed_module(sqlite3 *db) {
+  int rc = sqlite3_create_function(db, "packed_append", 3, SQLITE_UTF8,
+                                   nullptr, packed_append, nullptr, nullptr);
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+  return sqlite3_create_module(db, "packed", &packed_module, nullptr);
+}
+
+#endif // SQLITE_PERFORMANCE_SSB_PACKED_HPP
@@ -0,0 +1,152 @@
+#ifndef SQLITE_PERFORMANCE_SSB_PARTITION_HPP
+#define SQLITE_PERFORMANCE_SSB_PARTITION_HPP
+
+// Intra-query parallelism for SQLite. lineorder is split into rowid ranges,
+// one per worker connection. Each worker runs the unchanged query over its
+// range, with its own join and aggregate state. The partial results are then
+// loaded into temp.partial on another connection and merged by a query that
+// re-aggregates them (see sql/merge).
+
+#include "sqlite3.h"
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Rows copied out of the results of the workers.
+struct Partials {
+  int n_columns = 0;
+  std::vector<std::vector<sqlite3_value *>> rows;
+
+  Partials() = default;
+  Partials(const Partials &) = delete;
+  Partials &operator=(const Partials &) = delete;
+
+  ~Partials() { clear(); }
+
+  void clear() {
+    for (std::vector<sqlite3_value *> &row : rows) {
+      for (sqlite3_value *value : row) {
+        sqlite3_value_free(value);
+      }
+    }
+    rows.clear();
+  }
+};
+
+// Shadows lineorder in the temp schema of db with a view of partition i of n.
+// The view selects from source, which is main.lineorder or a virtual table
+// over it, so that the rowid range becomes a range scan.
+void partition_lineorder(sqlite3 *db, const std::string &source, int i,
+                         int n) {
+  sqlite3_stmt *stmt;
+  if (sqlite3_prepare_v2(db,
+                         "SELECT min(rowid), max(rowid) FROM main.lineorder",
+                         -1, &stmt, nullptr) != SQLITE_OK ||
+      sqlite3_step(stmt) != SQLITE_ROW) {
+    sqlite3_finalize(stmt);
+    throw std::runtime_error(sqlite3_errmsg(db));
+  }
+  sqlite3_int64 min = sqlite3_column_int64(stmt, 0);
+  sqlite3_int64 max = sqlite3_column_int64(stmt, 1);
+  sqlite3_finalize(stmt);
+
+  sqlite3_int64 size = (max - min) / n + 1;
+  sqlite3_int64 first = min + size * i;
+  sqlite3_int64 last = i == n - 1 ? max : first + size - 1;
+
+  std::string sql = "CREATE TEMP VIEW lineorder AS SELECT * FROM " + source +
+                    " WHERE rowid BETWEEN " + std::to_string(first) +
+                    " AND " + std::to_string(last);
+  char *message = nullptr;
+  if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &message) != SQLITE_OK) {
+    std::string error = message;
+    sqlite3_free(message);
+    throw std::runtime_error(error);
+  }
+}
+
+// Runs sql on every connection, each in its own thread, and collects the rows
+// of all results.
+void run_partitions(const std::vector<sqlite3 *> &dbs, const std::string &sql,
+                    Partials &partials) {
+  std::vector<Partials> results(dbs.size());
+  std::vector<std::string> errors(dbs.size());
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < dbs.size(); ++i) {
+    threads.emplace_back([&, i] {
+      sqlite3_stmt *stmt;
+      if (sqlite3_prepare_v2(dbs[i], sql.c_str(), -1, &stmt, nullptr) !=
+          SQLITE_OK) {
+        errors[i] = sqlite3_errmsg(dbs[i]);
+        return;
+      }
+      results[i].n_columns = sqlite3_column_count(stmt);
+      int rc;
+      while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        std::vector<sqlite3_value *> row;
+        for (int column = 0; column < results[i].n_columns; ++column) {
+          row.push_back(sqlite3_value_dup(sqlite3_column_value(stmt, column)));
+        }
+        results[i].rows.push_back(std::move(row));
+      }
+      if (rc != SQLITE_DONE) {
+        errors[i] = sqlite3_errmsg(dbs[i]);
+      }
+      sqlite3_finalize(stmt);
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  for (const std::string &error : errors) {
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+  }
+
+  partials.clear();
+  for (Partials &result : results) {
+    partials.n_columns = result.n_columns;
+    for (std::vector<sqlite3_value *> &row : result.rows) {
+      partials.rows.push_back(std::move(row));
+    }
+    result.rows.clear();
+  }
+}
+
+// Replaces temp.partial in db with the partial rows, in columns c0, c1, ...
+void load_partials(sqlite3 *db, const Partials &partials) {
+  std::string create = "CREATE TEMP TABLE partial(";
+  std::string insert = "INSERT INTO temp.partial VALUES (";
+  for (int i = 0; i < partials.n_columns; ++i) {
+    create += (i > 0 ? ", c" : "c") + std::to_string(i);
+    insert += i > 0 ? ", ?" : "?";
+  }
+  create += ")";
+  insert += ")";
+
+  std::string sql = "DROP TABLE IF EXISTS temp.partial; " + create;
+  sqlite3_stmt *stmt = nullptr;
+  if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK ||
+      sqlite3_prepare_v2(db, insert.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errmsg(db));
+  }
+  for (const std::vector<sqlite3_value *> &row : partials.rows) {
+    for (int i = 0; i < partials.n_columns; ++i) {
+      sqlite3_bind_value(stmt, i + 1, row[i]);
+    }
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+      std::string error = sqlite3_errmsg(db);
+      sqlite3_finalize(stmt);
+      throw std::runtime_error(error);
+    }
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+}
+
+#endif // SQLITE_PERFORMANCE_SSB_PARTITION_HPP
@@ -0,0 +1,138 @@
+#ifndef SQLITE_PERFORMANCE_SSB_PERF_COUNTERS_HPP
+#define SQLITE_PERFORMANCE_SSB_PERF_COUNTERS_HPP
+
+// Hardware performance counters of the calling thread, opened as one
+// perf_event_open group so that all of them count over exactly the same
+// instructions. The group is enabled around a query and read once, which
+// tells whether the cycles of a query go to cache misses, TLB misses or
+// branch mispredictions.
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class PerfCounters {
+public:
+  struct Event {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+  };
+
+  // The events, in the order of the columns that write() prints. The leader
+  // of the group is the first one.
+  static const std::vector<Event> &events() {
+    static const std::vector<Event> events = {
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {"dtlb_misses", PERF_TYPE_HW_CACHE,
+         PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    };
+    return events;
+  }
+
+  PerfCounters() {
+    for (const Event &event : events()) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = event.type;
+      attr.config = event.config;
+      attr.disabled = fds_.empty() ? 1 : 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+      int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1,
+                            fds_.empty() ? -1 : fds_[0], 0);
+      if (fd < 0) {
+        int error = errno;
+        close_all();
+        throw std::runtime_error(
+            std::string("Cannot open counter ") + event.name + ": " +
+            std::strerror(error) +
+            (error == EACCES || error == EPERM
+                 ? " (see /proc/sys/kernel/perf_event_paranoid)"
+                 : ""));
+      }
+      fds_.push_back(fd);
+    }
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  ~PerfCounters() { close_all(); }
+
+  // Resets the counters and starts counting.
+  void start() {
+    ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+
+  // Stops counting and returns a value per event. If the kernel had to
+  // multiplex the group with other events, the values are scaled up to the
+  // whole time that it was enabled.
+  std::vector<uint64_t> stop() {
+    ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    // nr, time_enabled, time_running, then a value per event.
+    std::vector<uint64_t> buffer(3 + fds_.size());
+    ssize_t expected = (ssize_t)(buffer.size() * sizeof(uint64_t));
+    if (read(fds_[0], buffer.data(), expected) != expected ||
+        buffer[0] != fds_.size()) {
+      throw std::runtime_error("Cannot read the performance counters");
+    }
+    uint64_t enabled = buffer[1];
+    uint64_t running = buffer[2];
+    std::vector<uint64_t> values(buffer.begin() + 3, buffer.end());
+    if (running > 0 && running < enabled) {
+      for (uint64_t &value : values) {
+        value = (uint64_t)((double)value * enabled / running);
+      }
+    }
+    return values;
+  }
+
+  // Writes the values of stop() to path as a CSV with a column per event.
+  static void write(const std::string &path,
+                    const std::vector<uint64_t> &values) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+      throw std::runtime_error("Cannot open " + path);
+    }
+    for (size_t i = 0; i < events().size(); ++i) {
+      out << (i > 0 ? "," : "") << events()[i].name;
+    }
+    out << "\n";
+    for (size_t i = 0; i < values.size(); ++i) {
+      out << (i > 0 ? "," : "") << values[i];
+    }
+    out << "\n";
+    if (!out) {
+      throw std::runtime_error("Cannot write " + path);
+    }
+  }
+
+private:
+  void close_all() {
+    for (int fd : fds_) {
+      close(fd);
+    }
+    fds_.clear();
+  }
+
+  std::vector<int> fds_;
+};
+
+#endif // SQLITE_PERFORMANCE_SSB_PERF_COUNTERS_HPP
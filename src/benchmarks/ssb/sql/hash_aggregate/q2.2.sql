@@ -0,0 +1,10 @@
+SELECT total, k0 AS d_year, k1 AS p_brand1
+FROM hash_aggregate('
+    SELECT d_year, p_brand1, lo_revenue
+    FROM lineorder, date, part, supplier
+    WHERE lo_orderdate = d_datekey
+      AND lo_partkey = p_partkey
+      AND lo_suppkey = s_suppkey
+      AND p_brand1 BETWEEN ''MFGR#2221'' AND ''MFGR#2228''
+      AND s_region = ''ASIA''')
+ORDER BY d_year, p_brand1;
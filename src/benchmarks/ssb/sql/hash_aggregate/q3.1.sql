@@ -0,0 +1,15 @@
+SELECT k0 AS c_nation, k1 AS s_nation, k2 AS d_year, total AS revenue
+FROM hash_aggregate('
+    SELECT c_nation, s_nation, d_year, lo_revenue
+    FROM customer,
+         lineorder,
+         supplier,
+         date
+    WHERE lo_custkey = c_custkey
+      AND lo_suppkey = s_suppkey
+      AND lo_orderdate = d_datekey
+      AND c_region = ''ASIA''
+      AND s_region = ''ASIA''
+      AND d_year >= 1992
+      and d_year <= 1997')
+ORDER BY d_year ASC, revenue DESC;
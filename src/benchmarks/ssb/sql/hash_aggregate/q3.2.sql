@@ -0,0 +1,15 @@
+SELECT k0 AS c_city, k1 AS s_city, k2 AS d_year, total AS revenue
+FROM hash_aggregate('
+    SELECT c_city, s_city, d_year, lo_revenue
+    FROM customer,
+         lineorder,
+         supplier,
+         date
+    WHERE lo_custkey = c_custkey
+      AND lo_suppkey = s_suppkey
+      AND lo_orderdate = d_datekey
+      AND c_nation = ''UNITED STATES''
+      AND s_nation = ''UNITED STATES''
+      AND d_year >= 1992
+      and d_year <= 1997')
+ORDER BY d_year ASC, revenue DESC;
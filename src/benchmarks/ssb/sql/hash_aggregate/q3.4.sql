@@ -0,0 +1,14 @@
+SELECT k0 AS c_city, k1 AS s_city, k2 AS d_year, total AS revenue
+FROM hash_aggregate('
+    SELECT c_city, s_city, d_year, lo_revenue
+    FROM customer,
+         lineorder,
+         supplier,
+         date
+    WHERE lo_custkey = c_custkey
+      AND lo_suppkey = s_suppkey
+      AND lo_orderdate = d_datekey
+      AND (c_city = ''UNITED KI1'' OR c_city = ''UNITED KI5'')
+      AND (s_city = ''UNITED KI1'' OR s_city = ''UNITED KI5'')
+      AND d_yearmonth = ''Dec1997''')
+ORDER BY d_year ASC, revenue DESC;
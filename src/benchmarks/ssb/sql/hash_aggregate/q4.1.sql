@@ -0,0 +1,16 @@
+SELECT k0 AS d_year, k1 AS c_nation, total AS profit
+FROM hash_aggregate('
+    SELECT d_year, c_nation, lo_revenue - lo_supplycost
+    FROM date,
+         customer,
+         supplier,
+         part,
+         lineorder
+    WHERE lo_custkey = c_custkey
+      AND lo_suppkey = s_suppkey
+      AND lo_partkey = p_partkey
+      AND lo_orderdate = d_datekey
+      AND c_region = ''AMERICA''
+      AND s_region = ''AMERICA''
+      AND (p_mfgr = ''MFGR#1'' OR p_mfgr = ''MFGR#2'')')
+ORDER BY d_year, c_nation;
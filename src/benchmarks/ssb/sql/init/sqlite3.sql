@@ -1,4 +1,8 @@
 DROP TABLE IF EXISTS lineorder;
+-- Derived from lineorder by ssb_sqlite3 --load --packed and --zone_maps.
+DROP TABLE IF EXISTS lineorder_packed;
+DROP TABLE IF EXISTS lineorder_packed_layout;
+DROP TABLE IF EXISTS lineorder_zonemap;
 DROP TABLE IF EXISTS part;
 DROP TABLE IF EXISTS supplier;
 DROP TABLE IF EXISTS customer;
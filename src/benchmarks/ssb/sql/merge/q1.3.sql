@@ -0,0 +1,2 @@
+SELECT SUM(c0) AS revenue
+FROM partial;
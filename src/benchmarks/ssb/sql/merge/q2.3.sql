@@ -0,0 +1,4 @@
+SELECT SUM(c0), c1, c2
+FROM partial
+GROUP BY c1, c2
+ORDER BY c1, c2;
@@ -0,0 +1,4 @@
+SELECT c0, c1, c2, SUM(c3) AS revenue
+FROM partial
+GROUP BY c0, c1, c2
+ORDER BY c2 ASC, revenue DESC;
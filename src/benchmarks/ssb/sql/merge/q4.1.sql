@@ -0,0 +1,4 @@
+SELECT c0, c1, SUM(c2) AS profit
+FROM partial
+GROUP BY c0, c1
+ORDER BY c0, c1;
@@ -0,0 +1,4 @@
+SELECT c0, c1, c2, SUM(c3) AS profit
+FROM partial
+GROUP BY c0, c1, c2
+ORDER BY c0, c1, c2;
@@ -1,3 +1,4 @@
+#include "colfile.hpp"
 #include "cxxopts.hpp"
 #include "helpers.hpp"
 #include "readfile.hpp"
@@ -9,14 +10,48 @@ void assert_success(const std::unique_ptr<duckdb::QueryResult> &result) {
   }
 }
 
+// Appends the column files of dbgen -D for table to it. The appender casts
+// the values to the column types as COPY does for the fields of the .tbl
+// files.
+void load_col(duckdb::Connection &conn, const std::string &table) {
+  ColTable file(table);
+  std::vector<bool> integer(file.n_columns());
+  for (size_t i = 0; i < file.n_columns(); ++i) {
+    integer[i] = file.integer(i);
+  }
+
+  duckdb::Appender appender(conn, table);
+  for (uint64_t row = 0; row < file.rows(); ++row) {
+    appender.BeginRow();
+    for (size_t i = 0; i < integer.size(); ++i) {
+      if (integer[i]) {
+        appender.Append<int64_t>(file.next_int(i));
+      } else {
+        std::string_view value = file.next_str(i);
+        appender.Append(value.data(), (uint32_t)value.size());
+      }
+    }
+    appender.EndRow();
+  }
+  appender.Close();
+}
+
 int main(int argc, char **argv) {
   cxxopts::Options options = ssb_options("ssb_duckdb", "SSB on DuckDB");
 
   cxxopts::OptionAdder adder = options.add_options("DuckDB");
   adder("load", "Load the database");
+  adder("load_format",
+        "Files that --load reads: the .tbl files (tbl) or the binary column "
+        "files of dbgen -D (col)",
+        cxxopts::value<std::string>()->default_value("tbl"));
   adder("run", "Run the benchmark");
   adder("memory_limit", "Memory limit",
         cxxopts::value<std::string>()->default_value("1GB"));
+  adder("streams",
+        "Number of concurrent query streams, each running the queries in its "
+        "own order on its own connection",
+        cxxopts::value<int>()->default_value("1"));
   adder("threads", "Number of threads",
         cxxopts::value<std::string>()->default_value("1"));
 
@@ -29,23 +64,41 @@ int main(int argc, char **argv) {
 
   auto memory_limit = result["memory_limit"].as<std::string>();
   auto threads = result["threads"].as<std::string>();
+  auto streams = result["streams"].as<int>();
+  if (streams < 1) {
+    throw std::runtime_error("--streams must be at least 1");
+  }
 
   duckdb::DuckDB db("ssb.duckdb");
 
   if (result.count("load")) {
     duckdb::Connection conn(db);
 
+    std::string format = result["load_format"].as<std::string>();
+    if (format != "tbl" && format != "col") {
+      throw std::runtime_error("Unknown load format: " + format);
+    }
+
     std::string sql = readfile("sql/init/duckdb.sql");
     assert_success(conn.Query(sql));
 
-    assert_success(conn.Query("COPY part FROM 'part.tbl' (AUTO_DETECT TRUE)"));
-    assert_success(
-        conn.Query("COPY supplier FROM 'supplier.tbl' (AUTO_DETECT TRUE)"));
-    assert_success(
-        conn.Query("COPY customer FROM 'customer.tbl' (AUTO_DETECT TRUE)"));
-    assert_success(conn.Query("COPY date FROM 'date.tbl' (AUTO_DETECT TRUE)"));
-    assert_success(
-        conn.Query("COPY lineorder FROM 'lineorder.tbl' (AUTO_DETECT TRUE)"));
+    if (format == "col") {
+      for (const std::string &table :
+           {"part", "supplier", "customer", "date", "lineorder"}) {
+        load_col(conn, table);
+      }
+    } else {
+      assert_success(
+          conn.Query("COPY part FROM 'part.tbl' (AUTO_DETECT TRUE)"));
+      assert_success(
+          conn.Query("COPY supplier FROM 'supplier.tbl' (AUTO_DETECT TRUE)"));
+      assert_success(
+          conn.Query("COPY customer FROM 'customer.tbl' (AUTO_DETECT TRUE)"));
+      assert_success(
+          conn.Query("COPY date FROM 'date.tbl' (AUTO_DETECT TRUE)"));
+      assert_success(
+          conn.Query("COPY lineorder FROM 'lineorder.tbl' (AUTO_DETECT TRUE)"));
+    }
   }
 
   if (result.count("run")) {
@@ -60,11 +113,26 @@ int main(int argc, char **argv) {
     assert_success(conn.Query("SELECT * FROM customer"));
     assert_success(conn.Query("SELECT * FROM date"));
 
-    for (const std::string &query :
-         {"q1.1", "q1.2", "q1.3", "q2.1", "q2.2", "q2.3", "q3.1", "q3.2",
-          "q3.3", "q3.4", "q4.1", "q4.2", "q4.3"}) {
-      std::string sql = readfile("sql/" + query + ".sql");
-      std::cout << time([&] { assert_success(conn.Query(sql)); });
+    std::map<std::string, std::string> sql;
+    for (const std::string &query : ssb_queries) {
+      sql[query] = readfile("sql/" + query + ".sql");
+    }
+
+    // The memory limit and the threads are settings of the database, so they
+    // apply to the connections of the streams as well.
+    if (streams > 1) {
+      std::vector<std::unique_ptr<duckdb::Connection>> conns;
+      for (int i = 0; i < streams; ++i) {
+        conns.push_back(std::make_unique<duckdb::Connection>(db));
+      }
+      print_streams(run_streams(streams, [&](int i, const std::string &query) {
+        assert_success(conns[i]->Query(sql[query]));
+      }));
+      return 0;
+    }
+
+    for (const std::string &query : ssb_queries) {
+      std::cout << time([&] { assert_success(conn.Query(sql[query])); });
       if (query != "q4.3") {
         std::cout << "," << std::flush;
       }
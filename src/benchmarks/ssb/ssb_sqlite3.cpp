@@ -1,7 +1,101 @@
+#include "batch_scan.hpp"
+#include "columnar.hpp"
 #include "cxxopts.hpp"
+#include "hash_aggregate.hpp"
+#include "hash_join.hpp"
 #include "helpers.hpp"
+#include "load.hpp"
+#include "packed.hpp"
+#include "partition.hpp"
+#include "perf_counters.hpp"
 #include "readfile.hpp"
 #include "sqlite3.hpp"
+#include "vdbe_profile.hpp"
+
+// Writes the packed copy of lineorder, unless it is up to date.
+void create_packed_lineorder(sqlite3 *db) {
+  char *message = nullptr;
+  if (create_packed_table(db, "lineorder", &message) != SQLITE_OK) {
+    std::string error = message != nullptr ? message : "packed: error";
+    sqlite3_free(message);
+    throw std::runtime_error(error);
+  }
+}
+
+// Applies the options to a connection that will run queries. If n_partitions
+// is greater than one, lineorder is restricted to partition i.
+void configure(sqlite::Connection &conn, const cxxopts::ParseResult &result,
+               BloomFilterRegistry *registry, ZoneMapStats *zone_maps,
+               const std::string &cache_size, int partition,
+               int n_partitions) {
+  uint64_t mask = result["bloom_filter"].as<bool>() ? 0 : 0x00080000;
+  int rc = sqlite3_test_control(SQLITE_TESTCTRL_OPTIMIZATIONS, conn.ptr().get(),
+                                mask);
+  if (rc != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errmsg(conn.ptr().get()));
+  }
+
+  conn.execute("PRAGMA cache_size=" + cache_size).expect(SQLITE_OK);
+
+  std::string lineorder = "main.lineorder";
+  if (result["vectorized"].as<bool>()) {
+    rc = create_batch_scan_module(conn.ptr().get(), registry, zone_maps);
+    if (rc != SQLITE_OK) {
+      throw std::runtime_error(sqlite3_errmsg(conn.ptr().get()));
+    }
+    lineorder = n_partitions > 1 ? "temp.lineorder_scan" : "temp.lineorder";
+    conn.execute("CREATE VIRTUAL TABLE " + lineorder +
+                 " USING batch_scan(lineorder)")
+        .expect(SQLITE_OK);
+  } else if (result["columnar"].as<bool>()) {
+    rc = create_columnar_module(conn.ptr().get());
+    if (rc != SQLITE_OK) {
+      throw std::runtime_error(sqlite3_errmsg(conn.ptr().get()));
+    }
+    lineorder = n_partitions > 1 ? "temp.lineorder_scan" : "temp.lineorder";
+    conn.execute("CREATE VIRTUAL TABLE " + lineorder +
+                 " USING columnar(lineorder, columnar)")
+        .expect(SQLITE_OK);
+  } else if (result["packed"].as<bool>()) {
+    rc = create_packed_module(conn.ptr().get());
+    if (rc != SQLITE_OK) {
+      throw std::runtime_error(sqlite3_errmsg(conn.ptr().get()));
+    }
+    lineorder = n_partitions > 1 ? "temp.lineorder_scan" : "temp.lineorder";
+    conn.execute("CREATE VIRTUAL TABLE " + lineorder +
+                 " USING packed(lineorder)")
+        .expect(SQLITE_OK);
+  }
+
+  if (n_partitions > 1) {
+    partition_lineorder(conn.ptr().get(), lineorder, partition, n_partitions);
+  }
+
+  if (result["hash_join"].as<bool>()) {
+    rc = create_hash_join_module(conn.ptr().get(), registry);
+    if (rc != SQLITE_OK) {
+      throw std::runtime_error(sqlite3_errmsg(conn.ptr().get()));
+    }
+    for (const std::string &table : {"part", "supplier", "customer", "date"}) {
+      conn.execute("CREATE VIRTUAL TABLE temp." + table + " USING hash_join(" +
+                   table + ")")
+          .expect(SQLITE_OK);
+    }
+  }
+
+  if (result["hash_aggregate"].as<bool>()) {
+    rc = create_hash_aggregate_module(conn.ptr().get());
+    if (rc != SQLITE_OK) {
+      throw std::runtime_error(sqlite3_errmsg(conn.ptr().get()));
+    }
+  }
+
+  conn.execute("SELECT * FROM lineorder").expect(SQLITE_OK);
+  conn.execute("SELECT * FROM part").expect(SQLITE_OK);
+  conn.execute("SELECT * FROM supplier").expect(SQLITE_OK);
+  conn.execute("SELECT * FROM customer").expect(SQLITE_OK);
+  conn.execute("SELECT * FROM date").expect(SQLITE_OK);
+}
 
 int main(int argc, char **argv) {
   cxxopts::Options options = ssb_options("ssb_sqlite3", "SSB on SQLite3");
@@ -9,8 +103,60 @@ int main(int argc, char **argv) {
   cxxopts::OptionAdder adder = options.add_options("SQLite3");
   adder("bloom_filter", "Use Bloom filters",
         cxxopts::value<bool>()->default_value("false"));
+  adder("bloom_filter_layout",
+        "Layout of the Bloom filters built by hash joins (flat, blocked)",
+        cxxopts::value<std::string>()->default_value("flat"));
   adder("cache_size", "Cache size",
         cxxopts::value<std::string>()->default_value("-1000000"));
+  adder("columnar",
+        "Scan lineorder from compressed column segments, written to "
+        "columnar/ when they are missing or out of date",
+        cxxopts::value<bool>()->default_value("false"));
+  adder("counters",
+        "Directory to write the instructions, LLC misses, dTLB misses and "
+        "branch misses of each query to, as <query>.csv",
+        cxxopts::value<std::string>()->default_value(""));
+  adder("hash_aggregate", "Group rows in hash tables instead of sorting them",
+        cxxopts::value<bool>()->default_value("false"));
+  adder("hash_join", "Probe the dimension tables through hash tables",
+        cxxopts::value<bool>()->default_value("false"));
+  adder("load",
+        "Load the .tbl files into ssb.sqlite and print the time of each "
+        "table, instead of running the queries (with --zone_maps, then "
+        "cluster lineorder on lo_orderdate and build its zone map, and with "
+        "--packed, then write lineorder_packed)");
+  adder("load_format",
+        "Files that --load reads: the .tbl files (tbl) or the binary column "
+        "files of dbgen -D (col)",
+        cxxopts::value<std::string>()->default_value("tbl"));
+  adder("packed",
+        "Scan lineorder from a copy with fixed-offset records in "
+        "lineorder_packed, which --load --packed writes (and a run writes "
+        "again if it is missing or lineorder has changed size)",
+        cxxopts::value<bool>()->default_value("false"));
+  adder("prefetch",
+        "Prefetch the hash index slots that the hash join probes of the rows "
+        "that pass the Bloom filters read, a few rows ahead of each probe",
+        cxxopts::value<bool>()->default_value("false"));
+  adder("profile",
+        "Directory to write the VDBE profile of each query to, as "
+        "<query>.csv (ssb_sqlite3_vdbe_profile only)",
+        cxxopts::value<std::string>()->default_value(""));
+  adder("streams",
+        "Number of concurrent query streams, each running the queries in its "
+        "own order on its own connection",
+        cxxopts::value<int>()->default_value("1"));
+  adder("threads",
+        "Number of threads, each scanning a range of lineorder (with --load, "
+        "parsing the .tbl files)",
+        cxxopts::value<int>()->default_value("1"));
+  adder("vectorized", "Scan lineorder a batch of rows at a time",
+        cxxopts::value<bool>()->default_value("false"));
+  adder("zone_maps",
+        "Skip the zones of lineorder whose minimum and maximum rule out the "
+        "constraints of the vectorized scan, from the zone map that "
+        "--load --zone_maps builds",
+        cxxopts::value<bool>()->default_value("false"));
 
   cxxopts::ParseResult result = options.parse(argc, argv);
 
@@ -19,34 +165,234 @@ int main(int argc, char **argv) {
     return 0;
   }
 
+  int threads = result["threads"].as<int>();
+  if (threads < 1) {
+    throw std::runtime_error("--threads must be at least 1");
+  }
+
+  // Only the writer of the load uses SQLite, so any build will do.
+  if (result.count("load")) {
+    std::string format = result["load_format"].as<std::string>();
+    if (format != "tbl" && format != "col") {
+      throw std::runtime_error("Unknown load format: " + format);
+    }
+    sqlite::Database db("ssb.sqlite");
+    sqlite::Connection conn;
+    db.connect(conn).expect(SQLITE_OK);
+    conn.execute("PRAGMA cache_size=" + result["cache_size"].as<std::string>())
+        .expect(SQLITE_OK);
+    std::vector<double> times =
+        load_ssb(conn.ptr().get(),
+                 load_statements(readfile("sql/init/sqlite3.sql")), threads,
+                 format == "col");
+    if (result["zone_maps"].as<bool>()) {
+      times.push_back(time([&] {
+        load_cluster(conn.ptr().get(), "lineorder", "lo_orderdate");
+        if (create_zone_map(conn.ptr().get(), "lineorder",
+                            {"lo_orderdate", "lo_discount", "lo_quantity"}) !=
+            SQLITE_OK) {
+          throw std::runtime_error(sqlite3_errmsg(conn.ptr().get()));
+        }
+      }));
+    }
+    if (result["packed"].as<bool>()) {
+      times.push_back(
+          time([&] { create_packed_lineorder(conn.ptr().get()); }));
+    }
+    for (size_t i = 0; i < times.size(); ++i) {
+      std::cout << (i > 0 ? "," : "") << times[i];
+    }
+    std::cout << std::endl;
+    return 0;
+  }
+  if (threads > 1 && sqlite3_threadsafe() == 0) {
+    throw std::runtime_error(
+        "--threads requires a thread-safe build of SQLite (ssb_sqlite3_mt)");
+  }
+
+  int streams = result["streams"].as<int>();
+  if (streams < 1) {
+    throw std::runtime_error("--streams must be at least 1");
+  }
+  if (streams > 1 && threads > 1) {
+    throw std::runtime_error("--streams and --threads are exclusive");
+  }
+  if (streams > 1 && sqlite3_threadsafe() == 0) {
+    throw std::runtime_error(
+        "--streams requires a thread-safe build of SQLite (ssb_sqlite3_mt)");
+  }
+
+  std::string profile = result["profile"].as<std::string>();
+  if (!profile.empty() && !vdbe_profile_enabled) {
+    throw std::runtime_error("--profile requires a build of SQLite with "
+                             "VDBE_PROFILE (ssb_sqlite3_vdbe_profile)");
+  }
+  if (!profile.empty()) {
+    create_directory(profile);
+  }
+
+  // The counters only follow the thread that opens them.
+  std::string counters_dir = result["counters"].as<std::string>();
+  std::unique_ptr<PerfCounters> counters;
+  if (!counters_dir.empty()) {
+    if (threads > 1 || streams > 1) {
+      throw std::runtime_error("--counters requires a single thread");
+    }
+    create_directory(counters_dir);
+    counters = std::make_unique<PerfCounters>();
+  }
+
+  if (result["columnar"].as<bool>() + result["packed"].as<bool>() +
+          result["vectorized"].as<bool>() >
+      1) {
+    throw std::runtime_error(
+        "--columnar, --packed and --vectorized are exclusive");
+  }
+
+  bool zone_maps = result["zone_maps"].as<bool>();
+  if (zone_maps && !result["vectorized"].as<bool>()) {
+    throw std::runtime_error("--zone_maps requires --vectorized");
+  }
+
+  BloomFilterLayout layout;
+  std::string layout_name = result["bloom_filter_layout"].as<std::string>();
+  if (layout_name == "flat") {
+    layout = BloomFilterLayout::flat;
+  } else if (layout_name == "blocked") {
+    layout = BloomFilterLayout::blocked;
+  } else {
+    throw std::runtime_error("Unknown Bloom filter layout: " + layout_name);
+  }
+
+  // Each connection has its own page cache, so the cache size is split
+  // between the workers or streams.
+  int n_connections = std::max(threads, streams);
+  std::string cache_size = result["cache_size"].as<std::string>();
+  if (n_connections > 1) {
+    cache_size = std::to_string(std::stoll(cache_size) / n_connections);
+  }
+
+  // Hash joins publish their filters for the scan of the same statement, so
+  // each connection has its own registry.
+  std::vector<BloomFilterRegistry> filters(n_connections);
+  bool prefetch = result["prefetch"].as<bool>();
+  if (prefetch && !(result["bloom_filter"].as<bool>() &&
+                    result["hash_join"].as<bool>() &&
+                    result["vectorized"].as<bool>())) {
+    throw std::runtime_error(
+        "--prefetch requires --bloom_filter, --hash_join and --vectorized");
+  }
+  for (BloomFilterRegistry &registry : filters) {
+    registry.layout = layout;
+    registry.prefetch = prefetch;
+  }
+  bool bloom_filter = result["bloom_filter"].as<bool>();
+
   sqlite::Database db("ssb.sqlite");
 
   sqlite::Connection conn;
   db.connect(conn).expect(SQLITE_OK);
 
-  uint64_t mask = result["bloom_filter"].as<bool>() ? 0 : 0x00080000;
-  int rc = sqlite3_test_control(SQLITE_TESTCTRL_OPTIMIZATIONS, conn.ptr().get(),
-                                mask);
-  if (rc != SQLITE_OK) {
-    throw std::runtime_error(sqlite3_errmsg(conn.ptr().get()));
+  // The zone map is built by the load, on lineorder clustered for it, and
+  // kept up to date by triggers afterwards.
+  if (zone_maps) {
+    bool exists;
+    if (zone_map_exists(conn.ptr().get(), "lineorder", exists) != SQLITE_OK) {
+      throw std::runtime_error(sqlite3_errmsg(conn.ptr().get()));
+    }
+    if (!exists) {
+      throw std::runtime_error(
+          "--zone_maps requires a database loaded with --load --zone_maps");
+    }
   }
+  ZoneMapStats zone_map_stats;
 
-  conn.execute("PRAGMA cache_size=" + result["cache_size"].as<std::string>())
-      .expect(SQLITE_OK);
+  // The packed copy is written by the load. A copy of another number of rows
+  // than lineorder has is stale and written again here.
+  if (result["packed"].as<bool>()) {
+    create_packed_lineorder(conn.ptr().get());
+  }
 
   conn.execute("ANALYZE").expect(SQLITE_OK);
 
-  conn.execute("SELECT * FROM lineorder").expect(SQLITE_OK);
-  conn.execute("SELECT * FROM part").expect(SQLITE_OK);
-  conn.execute("SELECT * FROM supplier").expect(SQLITE_OK);
-  conn.execute("SELECT * FROM customer").expect(SQLITE_OK);
-  conn.execute("SELECT * FROM date").expect(SQLITE_OK);
+  // Queries without GROUP BY have no hash_aggregate variant.
+  bool hash_aggregate = result["hash_aggregate"].as<bool>();
+  std::map<std::string, std::string> sql;
+  for (const std::string &query : ssb_queries) {
+    std::string filename = "sql/" + query + ".sql";
+    if (hash_aggregate &&
+        std::ifstream("sql/hash_aggregate/" + query + ".sql").is_open()) {
+      filename = "sql/hash_aggregate/" + query + ".sql";
+    }
+    sql[query] = readfile(filename);
+  }
+
+  if (streams > 1) {
+    std::vector<sqlite::Connection> conns(streams);
+    for (int i = 0; i < streams; ++i) {
+      db.connect(conns[i]).expect(SQLITE_OK);
+      configure(conns[i], result, bloom_filter ? &filters[i] : nullptr,
+                zone_maps ? &zone_map_stats : nullptr, cache_size, 0, 1);
+    }
+    print_streams(run_streams(streams, [&](int i, const std::string &query) {
+      conns[i].execute(sql[query]).expect(SQLITE_OK);
+    }));
+    if (zone_maps) {
+      std::cerr << "skipped " << zone_map_stats.skipped << " of "
+                << zone_map_stats.zones << " zones" << std::endl;
+    }
+    return 0;
+  }
 
-  for (const std::string &query :
-       {"q1.1", "q1.2", "q1.3", "q2.1", "q2.2", "q2.3", "q3.1", "q3.2", "q3.3",
-        "q3.4", "q4.1", "q4.2", "q4.3"}) {
-    std::string sql = readfile("sql/" + query + ".sql");
-    std::cout << time([&] { conn.execute(sql).expect(SQLITE_OK); });
+  // With several threads, conn only merges the partial results.
+  std::vector<sqlite::Connection> workers(threads > 1 ? threads : 0);
+  std::vector<sqlite3 *> worker_dbs;
+  if (threads > 1) {
+    for (int i = 0; i < threads; ++i) {
+      db.connect(workers[i]).expect(SQLITE_OK);
+      configure(workers[i], result, bloom_filter ? &filters[i] : nullptr,
+                zone_maps ? &zone_map_stats : nullptr, cache_size, i, threads);
+      worker_dbs.push_back(workers[i].ptr().get());
+    }
+  } else {
+    configure(conn, result, bloom_filter ? &filters[0] : nullptr,
+              zone_maps ? &zone_map_stats : nullptr, cache_size, 0, 1);
+  }
+
+  Partials partials;
+
+  for (const std::string &query : ssb_queries) {
+    if (threads > 1) {
+      std::string merge = readfile("sql/merge/" + query + ".sql");
+      std::cout << time([&] {
+        run_partitions(worker_dbs, sql[query], partials);
+        load_partials(conn.ptr().get(), partials);
+        conn.execute(merge).expect(SQLITE_OK);
+      });
+    } else {
+      // The profile is converted outside of the timed region.
+      if (!profile.empty()) {
+        vdbe_profile_reset();
+      }
+      if (counters) {
+        counters->start();
+      }
+      std::cout << time([&] { conn.execute(sql[query]).expect(SQLITE_OK); });
+      if (counters) {
+        PerfCounters::write(counters_dir + "/" + query + ".csv",
+                            counters->stop());
+      }
+      if (!profile.empty()) {
+        vdbe_profile_dump(profile + "/" + query + ".csv");
+      }
+    }
+    // Reported on stderr to keep stdout a row of timings.
+    if (zone_maps) {
+      std::cerr << query << ": skipped " << zone_map_stats.skipped << " of "
+                << zone_map_stats.zones << " zones" << std::endl;
+      zone_map_stats.zones = 0;
+      zone_map_stats.skipped = 0;
+    }
     if (query != "q4.3") {
       std::cout << "," << std::flush;
     }
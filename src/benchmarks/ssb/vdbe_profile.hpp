@@ -0,0 +1,106 @@
+#ifndef SQLITE_PERFORMANCE_SSB_VDBE_PROFILE_HPP
+#define SQLITE_PERFORMANCE_SSB_VDBE_PROFILE_HPP
+
+// Per-query VDBE profiles. A build of SQLite with VDBE_PROFILE counts the
+// executions and cycles of every opcode of a statement, and appends them to
+// vdbe_profile.out in the working directory when the statement is reset or
+// finalized. Removing the file before a query and converting it afterwards
+// gives the profile of that query alone, written as CSV with one row per
+// opcode of each statement.
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#ifdef VDBE_PROFILE
+constexpr bool vdbe_profile_enabled = true;
+#else
+constexpr bool vdbe_profile_enabled = false;
+#endif
+
+const char *const vdbe_profile_out = "vdbe_profile.out";
+
+// Discards the counters of the statements run so far.
+void vdbe_profile_reset() { std::remove(vdbe_profile_out); }
+
+std::string vdbe_profile_quote(const std::string &value) {
+  std::string quoted = "\"";
+  for (char c : value) {
+    quoted += c;
+    if (c == '"') {
+      quoted += '"';
+    }
+  }
+  return quoted + "\"";
+}
+
+// Writes the counters of the statements run since the last reset to path and
+// resets them. SQLite prints an opcode as
+//
+//   count cycles cycles/count address opcode p1 p2 p3 p4 p5
+//
+// where p4 is padded and may contain spaces, so it is what lies between p3
+// and p5, the last field (the build has no EXPLAIN comments). The lines that
+// start with "--" open a statement.
+void vdbe_profile_dump(const std::string &path) {
+  std::ifstream in(vdbe_profile_out);
+  if (!in.is_open()) {
+    throw std::runtime_error(std::string("Cannot open ") + vdbe_profile_out);
+  }
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  out << "statement,address,opcode,p1,p2,p3,p4,p5,count,cycles\n";
+
+  int statement = -1;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.compare(0, 4, "----") == 0) {
+      ++statement;
+      continue;
+    }
+    if (line.compare(0, 2, "--") == 0 || line.empty()) {
+      continue;
+    }
+
+    std::istringstream fields(line);
+    uint64_t count, cycles, average;
+    int address, p1, p2, p3;
+    std::string opcode;
+    if (!(fields >> count >> cycles >> average >> address >> opcode >> p1 >>
+          p2 >> p3)) {
+      throw std::runtime_error("Cannot parse " + std::string(vdbe_profile_out) +
+                               ": " + line);
+    }
+    std::string rest;
+    std::getline(fields, rest);
+    size_t end = rest.find_last_not_of(" \t\r");
+    size_t p5_begin =
+        end == std::string::npos ? std::string::npos : rest.rfind(' ', end);
+    if (p5_begin == std::string::npos) {
+      throw std::runtime_error("Cannot parse " + std::string(vdbe_profile_out) +
+                               ": " + line);
+    }
+    std::string p5 = rest.substr(p5_begin + 1, end - p5_begin);
+    std::string p4 = rest.substr(0, p5_begin);
+    size_t p4_begin = p4.find_first_not_of(' ');
+    p4 = p4_begin == std::string::npos
+             ? ""
+             : p4.substr(p4_begin, p4.find_last_not_of(' ') - p4_begin + 1);
+
+    out << statement << "," << address << "," << opcode << "," << p1 << ","
+        << p2 << "," << p3 << "," << vdbe_profile_quote(p4) << "," << p5
+        << "," << count << "," << cycles << "\n";
+  }
+
+  if (!out) {
+    throw std::runtime_error("Cannot write " + path);
+  }
+  vdbe_profile_reset();
+}
+
+#endif // SQLITE_PERFORMANCE_SSB_VDBE_PROFILE_HPP
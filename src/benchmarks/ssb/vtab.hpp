@@ -0,0 +1,247 @@
+#ifndef SQLITE_PERFORMANCE_SSB_VTAB_HPP
+#define SQLITE_PERFORMANCE_SSB_VTAB_HPP
+
+// Helpers shared by the virtual table modules that wrap a table of the main
+// schema.
+
+#include "sqlite3.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Values of one column for a range of rows. Text values are packed into one
+// buffer; row i spans [offsets[i], offsets[i + 1]).
+struct ColumnVector {
+  std::vector<sqlite3_int64> ints;
+  std::vector<char> chars;
+  std::vector<uint32_t> offsets = {0};
+
+  void clear() {
+    ints.clear();
+    chars.clear();
+    offsets.assign(1, 0);
+  }
+
+  void append_text(const char *text, size_t size) {
+    chars.insert(chars.end(), text, text + size);
+    offsets.push_back((uint32_t)chars.size());
+  }
+
+  void result(sqlite3_context *ctx, bool integer, size_t row) const {
+    if (integer) {
+      sqlite3_result_int64(ctx, ints[row]);
+    } else {
+      sqlite3_result_text(ctx, chars.data() + offsets[row],
+                          (int)(offsets[row + 1] - offsets[row]),
+                          SQLITE_TRANSIENT);
+    }
+  }
+};
+
+struct VtabColumns {
+  std::vector<std::string> names;
+  std::vector<bool> integer;
+  // Index of the INTEGER PRIMARY KEY column, or -1 if the table has none.
+  int rowid_alias = -1;
+};
+
+std::string vtab_quote(const std::string &identifier) {
+  std::string quoted = "\"";
+  for (char c : identifier) {
+    quoted += c;
+    if (c == '"') {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+// Strips the quotes from an argument of CREATE VIRTUAL TABLE, which SQLite
+// passes on as written.
+std::string vtab_dequote(const std::string &argument) {
+  if (argument.size() < 2 ||
+      std::string("'\"`").find(argument[0]) == std::string::npos ||
+      argument.back() != argument[0]) {
+    return argument;
+  }
+  std::string dequoted;
+  for (size_t i = 1; i + 1 < argument.size(); ++i) {
+    dequoted += argument[i];
+    if (argument[i] == argument[0]) {
+      ++i;
+    }
+  }
+  return dequoted;
+}
+
+// Reads the columns of main.<table>. Only INTEGER and TEXT columns are
+// supported.
+int vtab_columns(sqlite3 *db, const char *module, const std::string &table,
+                 VtabColumns &columns, char **pz_err) {
+  sqlite3_stmt *stmt;
+  int rc = sqlite3_prepare_v2(
+      db, "SELECT name, upper(type), pk FROM pragma_table_info(?1, 'main')", -1,
+      &stmt, nullptr);
+  if (rc != SQLITE_OK) {
+    *pz_err = sqlite3_mprintf("%s: %s", module, sqlite3_errmsg(db));
+    return rc;
+  }
+
+  // A single primary key column declared exactly INTEGER aliases the rowid.
+  int n_pk = 0;
+  bool rowid_alias = false;
+  sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_TRANSIENT);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    std::string name = (const char *)sqlite3_column_text(stmt, 0);
+    std::string type = (const char *)sqlite3_column_text(stmt, 1);
+    if (type.find("INT") != std::string::npos) {
+      columns.integer.push_back(true);
+    } else if (type.find("TEXT") != std::string::npos ||
+               type.find("CHAR") != std::string::npos) {
+      columns.integer.push_back(false);
+    } else {
+      *pz_err = sqlite3_mprintf("%s: column %s has unsupported type", module,
+                                name.c_str());
+      rc = SQLITE_ERROR;
+      break;
+    }
+    if (sqlite3_column_int(stmt, 2) > 0) {
+      ++n_pk;
+      rowid_alias = type == "INTEGER";
+      columns.rowid_alias = (int)columns.names.size();
+    }
+    columns.names.push_back(name);
+  }
+  sqlite3_finalize(stmt);
+
+  if (rc == SQLITE_OK && columns.names.empty()) {
+    *pz_err = sqlite3_mprintf("%s: no such table main.%s", module,
+                              table.c_str());
+    rc = SQLITE_ERROR;
+  }
+  if (n_pk != 1 || !rowid_alias) {
+    columns.rowid_alias = -1;
+  }
+  return rc;
+}
+
+// The first field of any sqlite_stat1 row is the number of rows in the table.
+// Without ANALYZE the default is returned.
+double vtab_row_estimate(sqlite3 *db, const std::string &table,
+                         double default_rows = 1000000) {
+  double rows = default_rows;
+  sqlite3_stmt *stmt;
+  if (sqlite3_prepare_v2(
+          db, "SELECT stat FROM main.sqlite_stat1 WHERE tbl = ?1 LIMIT 1", -1,
+          &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      rows = std::max(1.0, sqlite3_column_double(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+  }
+  return rows;
+}
+
+// Whether constraint i is a comparison against a constant of the column's own
+// type, which can be evaluated outside the VDBE without affinity conversions.
+// Column -1 is the rowid.
+bool vtab_constant_constraint(sqlite3_index_info *info, int i,
+                              const VtabColumns &columns) {
+  const auto &constraint = info->aConstraint[i];
+  if (!constraint.usable) {
+    return false;
+  }
+  switch (constraint.op) {
+  case SQLITE_INDEX_CONSTRAINT_EQ:
+  case SQLITE_INDEX_CONSTRAINT_NE:
+  case SQLITE_INDEX_CONSTRAINT_LT:
+  case SQLITE_INDEX_CONSTRAINT_LE:
+  case SQLITE_INDEX_CONSTRAINT_GT:
+  case SQLITE_INDEX_CONSTRAINT_GE:
+    break;
+  default:
+    return false;
+  }
+
+  sqlite3_value *rhs = nullptr;
+  if (sqlite3_vtab_rhs_value(info, i, &rhs) != SQLITE_OK) {
+    return false;
+  }
+  bool integer = constraint.iColumn < 0 || columns.integer[constraint.iColumn];
+  if (sqlite3_value_type(rhs) != (integer ? SQLITE_INTEGER : SQLITE_TEXT)) {
+    return false;
+  }
+  return integer ||
+         sqlite3_stricmp(sqlite3_vtab_collation(info, i), "BINARY") == 0;
+}
+
+// Whether a value that compares to the right-hand side as cmp satisfies op.
+bool vtab_satisfies(unsigned char op, int cmp) {
+  switch (op) {
+  case SQLITE_INDEX_CONSTRAINT_EQ:
+    return cmp == 0;
+  case SQLITE_INDEX_CONSTRAINT_NE:
+    return cmp != 0;
+  case SQLITE_INDEX_CONSTRAINT_LT:
+    return cmp < 0;
+  case SQLITE_INDEX_CONSTRAINT_LE:
+    return cmp <= 0;
+  case SQLITE_INDEX_CONSTRAINT_GT:
+    return cmp > 0;
+  case SQLITE_INDEX_CONSTRAINT_GE:
+    return cmp >= 0;
+  default:
+    return true;
+  }
+}
+
+// Narrows [min_rowid, max_rowid] to the rowids that satisfy `op v`.
+void vtab_rowid_range(unsigned char op, sqlite3_int64 v,
+                      sqlite3_int64 &min_rowid, sqlite3_int64 &max_rowid) {
+  switch (op) {
+  case SQLITE_INDEX_CONSTRAINT_EQ:
+    min_rowid = std::max(min_rowid, v);
+    max_rowid = std::min(max_rowid, v);
+    break;
+  case SQLITE_INDEX_CONSTRAINT_GT:
+    if (v == std::numeric_limits<sqlite3_int64>::max()) {
+      max_rowid = std::numeric_limits<sqlite3_int64>::min();
+      min_rowid = std::numeric_limits<sqlite3_int64>::max();
+    } else {
+      min_rowid = std::max(min_rowid, v + 1);
+    }
+    break;
+  case SQLITE_INDEX_CONSTRAINT_GE:
+    min_rowid = std::max(min_rowid, v);
+    break;
+  case SQLITE_INDEX_CONSTRAINT_LT:
+    if (v == std::numeric_limits<sqlite3_int64>::min()) {
+      max_rowid = std::numeric_limits<sqlite3_int64>::min();
+      min_rowid = std::numeric_limits<sqlite3_int64>::max();
+    } else {
+      max_rowid = std::min(max_rowid, v - 1);
+    }
+    break;
+  case SQLITE_INDEX_CONSTRAINT_LE:
+    max_rowid = std::min(max_rowid, v);
+    break;
+  }
+}
+
+int vtab_declare(sqlite3 *db, const VtabColumns &columns) {
+  std::ostringstream schema;
+  schema << "CREATE TABLE x(";
+  for (size_t i = 0; i < columns.names.size(); ++i) {
+    schema << (i > 0 ? ", " : "") << vtab_quote(columns.names[i])
+           << (columns.integer[i] ? " INTEGER" : " TEXT");
+  }
+  schema << ")";
+  return sqlite3_declare_vtab(db, schema.str().c_str());
+}
+
+#endif // SQLITE_PERFORMANCE_SSB_VTAB_HPP
@@ -0,0 +1,194 @@
+#ifndef SQLITE_PERFORMANCE_SSB_ZONE_MAP_HPP
+#define SQLITE_PERFORMANCE_SSB_ZONE_MAP_HPP
+
+// Zone maps: the minimum and maximum of selected integer columns of a rowid
+// table over each zone of 1024 consecutive rowids, kept in
+//
+//   <table>_zonemap(name, zone, min_value, max_value)
+//
+// in the main schema. Triggers widen a zone's bounds on every insert and
+// update, so the bounds always contain the values of the zone; deletes leave
+// them wider than they need to be. batch_scan reads only the zones whose
+// bounds can satisfy its constraints.
+//
+// A zone only gets narrow bounds if the table is stored in the order of the
+// column. dbgen writes lineorder in order key order, with dates drawn at
+// random, so ssb_sqlite3 --load --zone_maps first clusters lineorder on
+// lo_orderdate (load_cluster) and then builds the map.
+
+#include "sqlite3.h"
+#include "vtab.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A zone holds the rowids z << zone_map_shift to ((z + 1) << zone_map_shift)
+// - 1, so a zone is one full batch of a dense scan.
+constexpr int zone_map_shift = 10;
+
+// Zones counted by the scans that consulted a zone map.
+struct ZoneMapStats {
+  std::atomic<uint64_t> zones{0};
+  std::atomic<uint64_t> skipped{0};
+};
+
+std::string zone_map_table(const std::string &table) {
+  return table + "_zonemap";
+}
+
+// Creates the zone map of the columns of main.<table> and the triggers that
+// maintain it, unless they already exist.
+int create_zone_map(sqlite3 *db, const std::string &table,
+                    const std::vector<std::string> &columns) {
+  std::string zone_map = vtab_quote(zone_map_table(table));
+  std::string sql = "CREATE TABLE IF NOT EXISTS main." + zone_map +
+                    "(name TEXT, zone INTEGER, min_value INTEGER, "
+                    "max_value INTEGER, PRIMARY KEY (name, zone)) "
+                    "WITHOUT ROWID;";
+  for (const std::string &column : columns) {
+    std::string name = "'" + column + "'";
+    std::string quoted = vtab_quote(column);
+    sql += "INSERT INTO main." + zone_map + " SELECT " + name +
+           ", rowid >> " + std::to_string(zone_map_shift) + ", min(" + quoted +
+           "), max(" + quoted + ") FROM main." + vtab_quote(table) +
+           " WHERE NOT EXISTS (SELECT 1 FROM main." + zone_map +
+           " WHERE name = " + name + ") GROUP BY 2;";
+
+    // min() and max() with several arguments return NULL if any is NULL.
+    std::string upsert =
+        "INSERT INTO " + zone_map + " VALUES (" + name + ", new.rowid >> " +
+        std::to_string(zone_map_shift) + ", new." + quoted + ", new." + quoted +
+        ") ON CONFLICT (name, zone) DO UPDATE SET "
+        "min_value = coalesce(min(min_value, excluded.min_value), min_value, "
+        "excluded.min_value), "
+        "max_value = coalesce(max(max_value, excluded.max_value), max_value, "
+        "excluded.max_value);";
+    for (const std::string event : {"insert", "update"}) {
+      sql += "CREATE TRIGGER IF NOT EXISTS main." +
+             vtab_quote(zone_map_table(table) + "_" + column + "_" + event) +
+             " AFTER " + event + " ON " + vtab_quote(table) + " BEGIN " +
+             upsert + " END;";
+    }
+  }
+  return sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+}
+
+// Sets exists to whether main.<table> has a zone map.
+int zone_map_exists(sqlite3 *db, const std::string &table, bool &exists) {
+  sqlite3_stmt *stmt;
+  int rc = sqlite3_prepare_v2(
+      db, "SELECT 1 FROM main.sqlite_schema WHERE type = 'table' AND name = ?1",
+      -1, &stmt, nullptr);
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+  sqlite3_bind_text(stmt, 1, zone_map_table(table).c_str(), -1,
+                    SQLITE_TRANSIENT);
+  exists = sqlite3_step(stmt) == SQLITE_ROW;
+  return sqlite3_finalize(stmt);
+}
+
+// The columns of main.<table> that have a zone map.
+int zone_map_columns(sqlite3 *db, const std::string &table,
+                     const VtabColumns &columns, std::vector<bool> &mapped) {
+  mapped.assign(columns.names.size(), false);
+
+  bool exists;
+  int rc = zone_map_exists(db, table, exists);
+  if (rc != SQLITE_OK || !exists) {
+    return rc;
+  }
+
+  sqlite3_stmt *stmt;
+  std::string sql = "SELECT DISTINCT name FROM main." +
+                    vtab_quote(zone_map_table(table));
+  rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    auto *name = (const char *)sqlite3_column_text(stmt, 0);
+    auto it = std::find(columns.names.begin(), columns.names.end(), name);
+    size_t column = it - columns.names.begin();
+    if (it != columns.names.end() && columns.integer[column]) {
+      mapped[column] = true;
+    }
+  }
+  return sqlite3_finalize(stmt);
+}
+
+// Narrows zones, a sorted list, to the zones in [first_zone, last_zone] in
+// which `column op value` may hold, or fills it with them if fill is set.
+// n_zones is set to the number of zones of the column in that interval.
+int zone_map_select(sqlite3 *db, const std::string &table,
+                    const std::string &column, unsigned char op,
+                    sqlite3_int64 value, sqlite3_int64 first_zone,
+                    sqlite3_int64 last_zone, bool fill,
+                    std::vector<sqlite3_int64> &zones, uint64_t &n_zones) {
+  const char *condition;
+  switch (op) {
+  case SQLITE_INDEX_CONSTRAINT_EQ:
+    condition = "min_value <= ?2 AND max_value >= ?2";
+    break;
+  case SQLITE_INDEX_CONSTRAINT_NE:
+    condition = "NOT (min_value = ?2 AND max_value = ?2)";
+    break;
+  case SQLITE_INDEX_CONSTRAINT_LT:
+    condition = "min_value < ?2";
+    break;
+  case SQLITE_INDEX_CONSTRAINT_LE:
+    condition = "min_value <= ?2";
+    break;
+  case SQLITE_INDEX_CONSTRAINT_GT:
+    condition = "max_value > ?2";
+    break;
+  case SQLITE_INDEX_CONSTRAINT_GE:
+    condition = "max_value >= ?2";
+    break;
+  default:
+    condition = "1";
+  }
+
+  std::string sql = "SELECT zone, " + std::string(condition) + " FROM main." +
+                    vtab_quote(zone_map_table(table)) +
+                    " WHERE name = ?1 AND zone BETWEEN ?3 AND ?4 ORDER BY zone";
+  sqlite3_stmt *stmt;
+  int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
+  if (rc != SQLITE_OK) {
+    return rc;
+  }
+  sqlite3_bind_text(stmt, 1, column.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 2, value);
+  sqlite3_bind_int64(stmt, 3, first_zone);
+  sqlite3_bind_int64(stmt, 4, last_zone);
+
+  std::vector<sqlite3_int64> selected;
+  n_zones = 0;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    ++n_zones;
+    if (sqlite3_column_int(stmt, 1)) {
+      selected.push_back(sqlite3_column_int64(stmt, 0));
+    }
+  }
+  sqlite3_finalize(stmt);
+  if (rc != SQLITE_DONE) {
+    return rc;
+  }
+
+  if (fill) {
+    zones = std::move(selected);
+  } else {
+    std::vector<sqlite3_int64> both;
+    std::set_intersection(zones.begin(), zones.end(), selected.begin(),
+                          selected.end(), std::back_inserter(both));
+    zones = std::move(both);
+  }
+  return SQLITE_OK;
+}
+
+#endif // SQLITE_PERFORMANCE_SSB_ZONE_MAP_HPP
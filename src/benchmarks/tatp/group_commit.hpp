@@ -0,0 +1,118 @@
+#ifndef SQLITE_PERFORMANCE_TATP_GROUP_COMMIT_HPP
+#define SQLITE_PERFORMANCE_TATP_GROUP_COMMIT_HPP
+
+// Group commit for SQLite in WAL mode. The connections run with
+// synchronous=NORMAL, so a commit appends its frames to the WAL without
+// syncing it. After the commit, the client waits here until the WAL is
+// synced. The first client to wait leads a batch: it waits up to the
+// maximum delay for more commits, until the batch is full or no other
+// client is in a write transaction that could join it, then syncs the WAL
+// once for all of them, so a client that writes alone never waits.
+// fdatasync flushes the file, not the descriptor, so a descriptor of our
+// own is as good as the one of SQLite.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+class GroupCommit {
+public:
+  GroupCommit(std::string wal_path, std::chrono::microseconds max_delay,
+              uint64_t batch_size)
+      : wal_path_(std::move(wal_path)), max_delay_(max_delay),
+        batch_size_(batch_size) {}
+
+  GroupCommit(const GroupCommit &) = delete;
+  GroupCommit &operator=(const GroupCommit &) = delete;
+
+  ~GroupCommit() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  // Called before a write transaction begins, once however often it is
+  // retried, and followed by commit().
+  void begin() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++writing_;
+  }
+
+  // Returns once the WAL is synced past a transaction that has just
+  // committed.
+  void commit() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t ticket = ++committed_;
+    --writing_;
+    batch_cv_.notify_one();
+
+    while (synced_ < ticket) {
+      if (syncing_) {
+        synced_cv_.wait(lock);
+        continue;
+      }
+
+      // Commits that arrive while the WAL is synced wait for the next batch.
+      syncing_ = true;
+      batch_cv_.wait_for(lock, max_delay_, [&] {
+        return committed_ - synced_ >= batch_size_ || writing_ == 0;
+      });
+      uint64_t target = committed_;
+      lock.unlock();
+      sync();
+      lock.lock();
+      synced_ = target;
+      ++syncs_;
+      syncing_ = false;
+      synced_cv_.notify_all();
+    }
+  }
+
+  uint64_t commits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return committed_;
+  }
+
+  uint64_t syncs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return syncs_;
+  }
+
+private:
+  // Only the leader of a batch syncs, so the descriptor needs no lock. The
+  // WAL exists by the time of the first commit.
+  void sync() {
+    if (fd_ < 0) {
+      fd_ = open(wal_path_.c_str(), O_RDONLY);
+      if (fd_ < 0) {
+        throw std::runtime_error("Cannot open " + wal_path_);
+      }
+    }
+    if (fdatasync(fd_) != 0) {
+      throw std::runtime_error("Cannot sync " + wal_path_);
+    }
+  }
+
+  std::string wal_path_;
+  std::chrono::microseconds max_delay_;
+  uint64_t batch_size_;
+  int fd_ = -1;
+
+  mutable std::mutex mutex_;
+  std::condition_variable batch_cv_;
+  std::condition_variable synced_cv_;
+  uint64_t committed_ = 0;
+  uint64_t synced_ = 0;
+  uint64_t syncs_ = 0;
+  // Clients between begin() and commit().
+  uint64_t writing_ = 0;
+  bool syncing_ = false;
+};
+
+#endif // SQLITE_PERFORMANCE_TATP_GROUP_COMMIT_HPP
@@ -3,6 +3,7 @@
 
 #include "cxxopts.hpp"
 
+#include <array>
 #include <sstream>
 
 cxxopts::Options tatp_options(const std::string &program,
@@ -19,6 +20,12 @@ cxxopts::Options tatp_options(const std::string &program,
         cxxopts::value<size_t>()->default_value("10"));
   adder("measure", "Measure duration in seconds",
         cxxopts::value<size_t>()->default_value("60"));
+  adder("rate",
+        "Transactions per second arriving in an open loop, with latencies "
+        "measured from their arrival (default: a closed loop)",
+        cxxopts::value<double>()->default_value("0"));
+  adder("arrivals", "Arrivals of the open loop (fixed, poisson)",
+        cxxopts::value<std::string>()->default_value("poisson"));
   adder("help", "Print help");
   return options;
 }
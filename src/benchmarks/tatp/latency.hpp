@@ -0,0 +1,150 @@
+#ifndef SQLITE_PERFORMANCE_TATP_LATENCY_HPP
+#define SQLITE_PERFORMANCE_TATP_LATENCY_HPP
+
+// Latencies of the TATP procedures. Each worker, and so each thread, records
+// into histograms of its own, one per procedure type, which are merged once
+// the run is over.
+
+#include "dbbench/benchmarks/tatp.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <variant>
+#include <vector>
+
+// A histogram in the style of HdrHistogram: values below 128 have a bucket
+// each, and every power of two above has 64 buckets, so a value is known to
+// within 1/64 of itself whatever its magnitude.
+class LatencyHistogram {
+public:
+  LatencyHistogram() : counts_(bucket(UINT64_MAX) + 1) {}
+
+  void record(uint64_t value) {
+    ++counts_[bucket(value)];
+    ++count_;
+    max_ = std::max(max_, value);
+  }
+
+  void merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < counts_.size(); ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    max_ = std::max(max_, other.max_);
+  }
+
+  uint64_t count() const { return count_; }
+  uint64_t max() const { return max_; }
+
+  // The highest value of the bucket that holds the value of rank
+  // ceil(p * count), capped at the maximum.
+  uint64_t percentile(double p) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    auto rank = std::max<uint64_t>((uint64_t)std::ceil(p * (double)count_), 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        return std::min(highest(i), max_);
+      }
+    }
+    return max_;
+  }
+
+private:
+  static constexpr int sub_bucket_bits = 7;
+  static constexpr uint64_t half = 1 << (sub_bucket_bits - 1);
+
+  static size_t bucket(uint64_t value) {
+    if (value < 2 * half) {
+      return value;
+    }
+    int shift = 63 - __builtin_clzll(value) - (sub_bucket_bits - 1);
+    return (size_t)(shift * half + (value >> shift));
+  }
+
+  static uint64_t highest(size_t bucket) {
+    if (bucket < 2 * half) {
+      return bucket;
+    }
+    uint64_t shift = bucket / half - 1;
+    uint64_t lowest = (bucket - shift * half) << shift;
+    return lowest + ((uint64_t)1 << shift) - 1;
+  }
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_ = 0;
+  uint64_t max_ = 0;
+};
+
+const std::array<const char *, 7> procedure_names = {
+    "get_subscriber_data",    "get_new_destination",
+    "get_access_data",        "update_subscriber_data",
+    "update_location",        "insert_call_forwarding",
+    "delete_call_forwarding"};
+
+inline size_t procedure_type(const dbbench::tatp::GetSubscriberData &) {
+  return 0;
+}
+inline size_t procedure_type(const dbbench::tatp::GetNewDestination &) {
+  return 1;
+}
+inline size_t procedure_type(const dbbench::tatp::GetAccessData &) {
+  return 2;
+}
+inline size_t procedure_type(const dbbench::tatp::UpdateSubscriberData &) {
+  return 3;
+}
+inline size_t procedure_type(const dbbench::tatp::UpdateLocation &) {
+  return 4;
+}
+inline size_t procedure_type(const dbbench::tatp::InsertCallForwarding &) {
+  return 5;
+}
+inline size_t procedure_type(const dbbench::tatp::DeleteCallForwarding &) {
+  return 6;
+}
+
+// A histogram of latencies in nanoseconds per procedure type.
+class ProcedureLatencies {
+public:
+  // Records the latency of a procedure, a variant of the procedure types.
+  template <typename P>
+  void record(const P &procedure, std::chrono::steady_clock::duration latency) {
+    size_t type =
+        std::visit([](const auto &p) { return procedure_type(p); }, procedure);
+    histograms_[type].record(
+        (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(latency)
+            .count());
+  }
+
+  void clear() { histograms_ = {}; }
+
+  void merge(const ProcedureLatencies &other) {
+    for (size_t i = 0; i < histograms_.size(); ++i) {
+      histograms_[i].merge(other.histograms_[i]);
+    }
+  }
+
+  // Prints a CSV row per procedure type, in nanoseconds.
+  void print(std::ostream &out) const {
+    out << "procedure,count,p50,p99,p999,max" << std::endl;
+    for (size_t i = 0; i < histograms_.size(); ++i) {
+      const LatencyHistogram &h = histograms_[i];
+      out << procedure_names[i] << "," << h.count() << ","
+          << h.percentile(0.5) << "," << h.percentile(0.99) << ","
+          << h.percentile(0.999) << "," << h.max() << std::endl;
+    }
+  }
+
+private:
+  std::array<LatencyHistogram, 7> histograms_;
+};
+
+#endif // SQLITE_PERFORMANCE_TATP_LATENCY_HPP
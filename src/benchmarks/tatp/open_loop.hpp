@@ -0,0 +1,115 @@
+#ifndef SQLITE_PERFORMANCE_TATP_OPEN_LOOP_HPP
+#define SQLITE_PERFORMANCE_TATP_OPEN_LOOP_HPP
+
+// An open-loop alternative to dbbench::run. Transactions arrive on a schedule
+// of their own, at a fixed rate or as a Poisson process, whether or not the
+// workers keep up. Each worker thread takes the next arrival, waits for its
+// time if it is early, and runs it. The latency is measured from the
+// scheduled time, so the time that an arrival spends queued behind a slow
+// transaction counts towards its latency instead of delaying the arrival.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ArrivalSchedule {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  ArrivalSchedule(Clock::time_point start, double rate, bool poisson)
+      : next_(start), rate_(rate), poisson_(poisson), interarrival_(rate) {}
+
+  // The time of the next arrival.
+  Clock::time_point next() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clock::time_point arrival = next_;
+    double seconds = poisson_ ? interarrival_(generator_) : 1.0 / rate_;
+    next_ += std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds));
+    return arrival;
+  }
+
+private:
+  std::mutex mutex_;
+  Clock::time_point next_;
+  double rate_;
+  bool poisson_;
+  std::mt19937_64 generator_;
+  std::exponential_distribution<double> interarrival_;
+};
+
+// Parses the value of --arrivals.
+bool poisson_arrivals(const std::string &arrivals) {
+  if (arrivals == "poisson") {
+    return true;
+  }
+  if (arrivals == "fixed") {
+    return false;
+  }
+  throw std::runtime_error("Unknown arrivals: " + arrivals);
+}
+
+// Runs the workers, one thread each, against arrivals at rate per second
+// for warmup and then measure seconds, and returns the throughput of the
+// successful transactions of the measured arrivals. A worker is called with
+// the scheduled time of its arrival, and its latencies are cleared when it
+// takes its first measured arrival. Arrivals that have not started by the
+// end are dropped.
+template <typename Worker>
+double run_open_loop(std::vector<Worker> &workers, double rate, bool poisson,
+                     size_t warmup, size_t measure) {
+  using Clock = ArrivalSchedule::Clock;
+
+  if (rate <= 0) {
+    throw std::runtime_error("--rate must be positive");
+  }
+
+  Clock::time_point start = Clock::now();
+  Clock::time_point measure_start = start + std::chrono::seconds(warmup);
+  Clock::time_point end = measure_start + std::chrono::seconds(measure);
+  ArrivalSchedule schedule(start, rate, poisson);
+  std::atomic<uint64_t> committed = 0;
+
+  std::vector<std::thread> threads;
+  for (Worker &worker : workers) {
+    threads.emplace_back([&] {
+      bool measuring = false;
+      uint64_t n = 0;
+      while (true) {
+        Clock::time_point scheduled = schedule.next();
+        if (scheduled >= end) {
+          break;
+        }
+        std::this_thread::sleep_until(scheduled);
+        if (Clock::now() >= end) {
+          break;
+        }
+        if (!measuring && scheduled >= measure_start) {
+          worker.clear_latencies();
+          measuring = true;
+        }
+        if (worker(scheduled) && measuring) {
+          ++n;
+        }
+      }
+      if (!measuring) {
+        worker.clear_latencies();
+      }
+      committed += n;
+    });
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  return (double)committed / (double)measure;
+}
+
+#endif // SQLITE_PERFORMANCE_TATP_OPEN_LOOP_HPP
@@ -0,0 +1,315 @@
+#ifndef SQLITE_PERFORMANCE_TATP_TATP_SQLITE3_HPP
+#define SQLITE_PERFORMANCE_TATP_TATP_SQLITE3_HPP
+
+#include "dbbench/benchmarks/tatp.hpp"
+#include "group_commit.hpp"
+#include "helpers.hpp"
+#include "latency.hpp"
+#include "sqlite3.hpp"
+
+#include <array>
+#include <iostream>
+#include <string>
+#include <utility>
+
+template <class... Ts> struct overloaded : Ts... { using Ts::operator()...; };
+template <class... Ts> overloaded(Ts...) -> overloaded<Ts...>;
+
+void load(sqlite::Database &db, uint64_t n_subscriber_records) {
+  sqlite::Connection conn;
+  db.connect(conn).expect(SQLITE_OK);
+  for (const std::string &sql : tatp_create_sql("INTEGER", "INTEGER", "INTEGER",
+                                                "INTEGER", "TEXT", true)) {
+    conn.execute(sql).expect(SQLITE_OK);
+  }
+
+  sqlite::Statement subscriber;
+  conn.prepare(subscriber, "INSERT INTO subscriber VALUES ("
+                           "?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,"
+                           "?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)")
+      .expect(SQLITE_OK);
+
+  sqlite::Statement access_info;
+  conn.prepare(access_info, "INSERT INTO access_info VALUES (?,?,?,?,?,?)")
+      .expect(SQLITE_OK);
+
+  sqlite::Statement special_facility;
+  conn.prepare(special_facility,
+               "INSERT INTO special_facility VALUES (?,?,?,?,?,?)")
+      .expect(SQLITE_OK);
+
+  sqlite::Statement call_forwarding;
+  conn.prepare(call_forwarding,
+               "INSERT INTO call_forwarding VALUES (?,?,?,?,?)")
+      .expect(SQLITE_OK);
+
+  conn.begin();
+
+  dbbench::tatp::RecordGenerator record_generator(n_subscriber_records);
+  while (auto record = record_generator.next()) {
+    std::visit(
+        overloaded{
+            [&](const dbbench::tatp::SubscriberRecord &r) {
+              subscriber.bind_int64(1, (sqlite3_int64)r.s_id).expect(SQLITE_OK);
+              subscriber.bind_text(2, r.sub_nbr).expect(SQLITE_OK);
+              for (int i = 0; i < 10; ++i) {
+                subscriber.bind_int(i + 3, r.bit[i]).expect(SQLITE_OK);
+              }
+              for (int i = 0; i < 10; ++i) {
+                subscriber.bind_int(i + 13, r.hex[i]).expect(SQLITE_OK);
+              }
+              for (int i = 0; i < 10; ++i) {
+                subscriber.bind_int(i + 23, r.byte2[i]).expect(SQLITE_OK);
+              }
+              subscriber.bind_int64(33, (sqlite3_int64)r.msc_location)
+                  .expect(SQLITE_OK);
+              subscriber.bind_int64(34, (sqlite3_int64)r.vlr_location)
+                  .expect(SQLITE_OK);
+              subscriber.execute().expect(SQLITE_OK);
+            },
+
+            [&](const dbbench::tatp::AccessInfoRecord &r) {
+              access_info
+                  .bind_all((sqlite3_int64)r.s_id, (int)r.ai_type, (int)r.data1,
+                            (int)r.data2, r.data3.c_str(), r.data4.c_str())
+                  .expect(SQLITE_OK);
+              access_info.execute().expect(SQLITE_OK);
+            },
+
+            [&](const dbbench::tatp::SpecialFacilityRecord &r) {
+              special_facility
+                  .bind_all((sqlite3_int64)r.s_id, (int)r.sf_type,
+                            (int)r.is_active, (int)r.error_cntrl, (int)r.data_a,
+                            r.data_b.c_str())
+                  .expect(SQLITE_OK);
+              special_facility.execute().expect(SQLITE_OK);
+            },
+
+            [&](const dbbench::tatp::CallForwardingRecord &r) {
+              call_forwarding
+                  .bind_all((sqlite3_int64)r.s_id, (int)r.sf_type,
+                            (int)r.start_time, (int)r.end_time,
+                            r.numberx.c_str())
+                  .expect(SQLITE_OK);
+              call_forwarding.execute().expect(SQLITE_OK);
+            },
+        },
+        *record);
+  }
+
+  conn.commit();
+}
+
+// The write transactions of TATP, in the order of the rows of
+// print_write_stats().
+enum WriteTransaction {
+  update_subscriber_data,
+  update_location,
+  insert_call_forwarding,
+  delete_call_forwarding,
+  n_write_transactions
+};
+
+const std::array<const char *, n_write_transactions> write_transaction_names =
+    {"update_subscriber_data", "update_location", "insert_call_forwarding",
+     "delete_call_forwarding"};
+
+// Commits, and aborts that were retried, per write transaction.
+struct WriteStats {
+  std::array<uint64_t, n_write_transactions> commits = {};
+  std::array<uint64_t, n_write_transactions> aborts = {};
+};
+
+void print_write_stats(const WriteStats &stats) {
+  std::cerr << "transaction,commits,aborts" << std::endl;
+  for (size_t i = 0; i < n_write_transactions; ++i) {
+    std::cerr << write_transaction_names[i] << "," << stats.commits[i] << ","
+              << stats.aborts[i] << std::endl;
+  }
+}
+
+class Worker {
+public:
+  // With concurrent, the write transactions start with BEGIN CONCURRENT,
+  // which needs SQLite from the begin-concurrent branch. With group_commit,
+  // a write transaction only returns once group_commit has synced the WAL.
+  Worker(sqlite::Connection conn, uint64_t n_subscriber_records,
+         bool concurrent = false, GroupCommit *group_commit = nullptr)
+      : conn_(std::move(conn)), procedure_generator_(n_subscriber_records),
+        begin_(concurrent ? "BEGIN CONCURRENT" : "BEGIN IMMEDIATE"),
+        group_commit_(group_commit) {
+    std::array<std::string, 10> sql = tatp_statement_sql();
+    for (int i = 0; i < 10; ++i) {
+      conn_.prepare(stmts_[i], sql[i]).expect(SQLITE_OK);
+    }
+  }
+
+  bool operator()() { return (*this)(std::chrono::steady_clock::now()); }
+
+  // Runs the next procedure, with its latency measured from start, which an
+  // open loop sets to the time that the procedure was scheduled for.
+  bool operator()(std::chrono::steady_clock::time_point start) {
+    auto procedure = procedure_generator_.next();
+    bool success = std::visit(
+        overloaded{
+            [&](const dbbench::tatp::GetSubscriberData &p) {
+              stmts_[0].bind_all((sqlite3_int64)p.s_id).expect(SQLITE_OK);
+              stmts_[0].execute().expect(SQLITE_OK);
+              return true;
+            },
+
+            [&](const dbbench::tatp::GetNewDestination &p) {
+              stmts_[1]
+                  .bind_all((sqlite3_int64)p.s_id, (int)p.sf_type,
+                            (int)p.start_time, (int)p.end_time)
+                  .expect(SQLITE_OK);
+              size_t count;
+              stmts_[1].execute(count).expect(SQLITE_OK);
+              return count > 0;
+            },
+
+            [&](const dbbench::tatp::GetAccessData &p) {
+              stmts_[2]
+                  .bind_all((sqlite3_int64)p.s_id, (int)p.ai_type)
+                  .expect(SQLITE_OK);
+              size_t count = 0;
+              stmts_[2].execute(count).expect(SQLITE_OK);
+              return count > 0;
+            },
+
+            [&](const dbbench::tatp::UpdateSubscriberData &p) {
+              return write(update_subscriber_data, [&] {
+                stmts_[3]
+                    .bind_all((int)p.bit_1, (sqlite3_int64)p.s_id)
+                    .expect(SQLITE_OK);
+                stmts_[3].execute().expect(SQLITE_OK);
+
+                stmts_[4]
+                    .bind_all((int)p.data_a, (sqlite3_int64)p.s_id,
+                              (int)p.sf_type)
+                    .expect(SQLITE_OK);
+                stmts_[4].execute().expect(SQLITE_OK);
+
+                return conn_.changes() > 0;
+              });
+            },
+
+            [&](const dbbench::tatp::UpdateLocation &p) {
+              return write(update_location, [&] {
+                stmts_[5]
+                    .bind_all((sqlite3_int64)p.vlr_location,
+                              p.sub_nbr.c_str())
+                    .expect(SQLITE_OK);
+                stmts_[5].execute().expect(SQLITE_OK);
+                return true;
+              });
+            },
+
+            [&](const dbbench::tatp::InsertCallForwarding &p) {
+              return write(insert_call_forwarding, [&] {
+                stmts_[6].bind_all(p.sub_nbr.c_str()).expect(SQLITE_OK);
+                stmts_[6].step().expect(SQLITE_ROW);
+                uint64_t s_id = stmts_[6].column_int64(0);
+                stmts_[6].reset().expect(SQLITE_OK);
+
+                stmts_[7].bind(1, (sqlite3_int64)s_id).expect(SQLITE_OK);
+                stmts_[7].execute().expect(SQLITE_OK);
+
+                stmts_[8]
+                    .bind_all((sqlite3_int64)s_id, (int)p.sf_type,
+                              (int)p.start_time, (int)p.end_time,
+                              p.numberx.c_str())
+                    .expect(SQLITE_OK);
+                sqlite::Result rc = stmts_[8].execute();
+                if (rc != SQLITE_OK) {
+                  rc.expect(SQLITE_CONSTRAINT);
+                  return false;
+                }
+                return true;
+              });
+            },
+
+            [&](const dbbench::tatp::DeleteCallForwarding &p) {
+              return write(delete_call_forwarding, [&] {
+                stmts_[6].bind_all(p.sub_nbr.c_str()).expect(SQLITE_OK);
+                stmts_[6].step().expect(SQLITE_ROW);
+                uint64_t s_id = stmts_[6].column_int64(0);
+                stmts_[6].reset().expect(SQLITE_OK);
+
+                stmts_[9]
+                    .bind_all((sqlite3_int64)s_id, (int)p.sf_type,
+                              (int)p.start_time)
+                    .expect(SQLITE_OK);
+                stmts_[9].execute().expect(SQLITE_OK);
+
+                return conn_.changes() > 0;
+              });
+            },
+        },
+        procedure);
+    if (start >= measure_start_) {
+      latencies_.record(procedure, std::chrono::steady_clock::now() - start);
+    }
+    return success;
+  }
+
+  const ProcedureLatencies &latencies() const { return latencies_; }
+  void clear_latencies() { latencies_.clear(); }
+
+  // Leaves the latencies of the procedures that start before measure_start
+  // out, as a closed loop has no boundary at which to clear them.
+  void measure_from(std::chrono::steady_clock::time_point measure_start) {
+    measure_start_ = measure_start;
+  }
+
+  const WriteStats &write_stats() const { return write_stats_; }
+
+private:
+  // Runs body, which returns whether the transaction succeeded, in a write
+  // transaction.
+  //
+  // BEGIN IMMEDIATE takes the write lock up front. With several clients, a
+  // deferred transaction that reads before it writes fails at once with
+  // SQLITE_BUSY_SNAPSHOT if another client commits in between, while BEGIN
+  // IMMEDIATE waits for the busy timeout.
+  //
+  // BEGIN CONCURRENT defers the lock to the commit, which fails with
+  // SQLITE_BUSY_SNAPSHOT if another client has committed a change to a page
+  // that the transaction read. The transaction is then rolled back and run
+  // again from the start.
+  template <typename F> bool write(WriteTransaction type, F &&body) {
+    if (group_commit_ != nullptr) {
+      group_commit_->begin();
+    }
+    while (true) {
+      conn_.execute(begin_).expect(SQLITE_OK);
+      bool success = body();
+      sqlite::Result rc = conn_.commit();
+      if (rc != SQLITE_OK) {
+        if ((sqlite3_extended_errcode(conn_.ptr().get()) & 0xff) !=
+            SQLITE_BUSY) {
+          rc.expect(SQLITE_OK);
+        }
+        conn_.execute("ROLLBACK").expect(SQLITE_OK);
+        ++write_stats_.aborts[type];
+        continue;
+      }
+      ++write_stats_.commits[type];
+      if (group_commit_ != nullptr) {
+        group_commit_->commit();
+      }
+      return success;
+    }
+  }
+
+  sqlite::Connection conn_;
+  std::array<sqlite::Statement, 10> stmts_;
+  dbbench::tatp::ProcedureGenerator procedure_generator_;
+  ProcedureLatencies latencies_;
+  std::chrono::steady_clock::time_point measure_start_;
+  std::string begin_;
+  GroupCommit *group_commit_;
+  WriteStats write_stats_;
+};
+
+#endif // SQLITE_PERFORMANCE_TATP_TATP_SQLITE3_HPP
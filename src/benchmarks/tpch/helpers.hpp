@@ -0,0 +1,29 @@
+#ifndef SQLITE_PERFORMANCE_TPCH_HELPERS_HPP
+#define SQLITE_PERFORMANCE_TPCH_HELPERS_HPP
+
+#include "benchmarks/ssb/helpers.hpp"
+
+#include <array>
+#include <cxxopts.hpp>
+#include <string>
+
+const std::array<std::string, 22> tpch_queries = {
+    "q1",  "q2",  "q3",  "q4",  "q5",  "q6",  "q7",  "q8",
+    "q9",  "q10", "q11", "q12", "q13", "q14", "q15", "q16",
+    "q17", "q18", "q19", "q20", "q21", "q22"};
+
+// In the order of the foreign keys, although the loaders only check them
+// once every table is loaded.
+const std::array<std::string, 8> tpch_tables = {
+    "region",   "nation",   "part",   "supplier",
+    "partsupp", "customer", "orders", "lineitem"};
+
+cxxopts::Options tpch_options(const std::string &program,
+                              const std::string &help_string = "") {
+  cxxopts::Options options(program, help_string);
+  cxxopts::OptionAdder adder = options.add_options();
+  adder("help", "Print help");
+  return options;
+}
+
+#endif // SQLITE_PERFORMANCE_TPCH_HELPERS_HPP
@@ -0,0 +1,126 @@
+DROP TABLE IF EXISTS lineitem;
+DROP TABLE IF EXISTS orders;
+DROP TABLE IF EXISTS partsupp;
+DROP TABLE IF EXISTS customer;
+DROP TABLE IF EXISTS supplier;
+DROP TABLE IF EXISTS part;
+DROP TABLE IF EXISTS nation;
+DROP TABLE IF EXISTS region;
+
+CREATE TABLE region
+(
+    r_regionkey INTEGER,
+    r_name      TEXT,
+    r_comment   TEXT,
+    PRIMARY KEY (r_regionkey)
+);
+
+CREATE TABLE nation
+(
+    n_nationkey INTEGER,
+    n_name      TEXT,
+    n_regionkey INTEGER,
+    n_comment   TEXT,
+    PRIMARY KEY (n_nationkey),
+    FOREIGN KEY (n_regionkey) REFERENCES region (r_regionkey)
+);
+
+CREATE TABLE part
+(
+    p_partkey     INTEGER,
+    p_name        TEXT,
+    p_mfgr        TEXT,
+    p_brand       TEXT,
+    p_type        TEXT,
+    p_size        INTEGER,
+    p_container   TEXT,
+    p_retailprice REAL,
+    p_comment     TEXT,
+    PRIMARY KEY (p_partkey)
+);
+
+CREATE TABLE supplier
+(
+    s_suppkey   INTEGER,
+    s_name      TEXT,
+    s_address   TEXT,
+    s_nationkey INTEGER,
+    s_phone     TEXT,
+    s_acctbal   REAL,
+    s_comment   TEXT,
+    PRIMARY KEY (s_suppkey),
+    FOREIGN KEY (s_nationkey) REFERENCES nation (n_nationkey)
+);
+
+CREATE TABLE partsupp
+(
+    ps_partkey    INTEGER,
+    ps_suppkey    INTEGER,
+    ps_availqty   INTEGER,
+    ps_supplycost REAL,
+    ps_comment    TEXT,
+    PRIMARY KEY (ps_partkey, ps_suppkey),
+    FOREIGN KEY (ps_partkey) REFERENCES part (p_partkey),
+    FOREIGN KEY (ps_suppkey) REFERENCES supplier (s_suppkey)
+);
+
+CREATE TABLE customer
+(
+    c_custkey    INTEGER,
+    c_name       TEXT,
+    c_address    TEXT,
+    c_nationkey  INTEGER,
+    c_phone      TEXT,
+    c_acctbal    REAL,
+    c_mktsegment TEXT,
+    c_comment    TEXT,
+    PRIMARY KEY (c_custkey),
+    FOREIGN KEY (c_nationkey) REFERENCES nation (n_nationkey)
+);
+
+CREATE TABLE orders
+(
+    o_orderkey      INTEGER,
+    o_custkey       INTEGER,
+    o_orderstatus   TEXT,
+    o_totalprice    REAL,
+    o_orderdate     TEXT,
+    o_orderpriority TEXT,
+    o_clerk         TEXT,
+    o_shippriority  INTEGER,
+    o_comment       TEXT,
+    PRIMARY KEY (o_orderkey),
+    FOREIGN KEY (o_custkey) REFERENCES customer (c_custkey)
+);
+
+CREATE TABLE lineitem
+(
+    l_orderkey      INTEGER,
+    l_partkey       INTEGER,
+    l_suppkey       INTEGER,
+    l_linenumber    INTEGER,
+    l_quantity      REAL,
+    l_extendedprice REAL,
+    l_discount      REAL,
+    l_tax           REAL,
+    l_returnflag    TEXT,
+    l_linestatus    TEXT,
+    l_shipdate      TEXT,
+    l_commitdate    TEXT,
+    l_receiptdate   TEXT,
+    l_shipinstruct  TEXT,
+    l_shipmode      TEXT,
+    l_comment       TEXT,
+    PRIMARY KEY (l_orderkey, l_linenumber),
+    FOREIGN KEY (l_orderkey) REFERENCES orders (o_orderkey),
+    FOREIGN KEY (l_partkey, l_suppkey) REFERENCES partsupp (ps_partkey, ps_suppkey)
+);
+
+.import region.tbl region
+.import nation.tbl nation
+.import part.tbl part
+.import supplier.tbl supplier
+.import partsupp.tbl partsupp
+.import customer.tbl customer
+.import orders.tbl orders
+.import lineitem.tbl lineitem
@@ -0,0 +1,2 @@
+CREATE INDEX lineitem_partsupp ON lineitem (l_partkey, l_suppkey);
+CREATE INDEX orders_customer ON orders (o_custkey);
@@ -0,0 +1,72 @@
+#include "cxxopts.hpp"
+#include "helpers.hpp"
+#include "readfile.hpp"
+#include "systems/duckdb/duckdb.hpp"
+
+void assert_success(const std::unique_ptr<duckdb::QueryResult> &result) {
+  if (!result->success) {
+    throw std::runtime_error(result->error);
+  }
+}
+
+int main(int argc, char **argv) {
+  cxxopts::Options options = tpch_options("tpch_duckdb", "TPC-H on DuckDB");
+
+  cxxopts::OptionAdder adder = options.add_options("DuckDB");
+  adder("load", "Load the database");
+  adder("run", "Run the benchmark");
+  adder("memory_limit", "Memory limit",
+        cxxopts::value<std::string>()->default_value("1GB"));
+  adder("threads", "Number of threads",
+        cxxopts::value<std::string>()->default_value("1"));
+
+  cxxopts::ParseResult result = options.parse(argc, argv);
+
+  if (result.count("help")) {
+    std::cout << options.help();
+    return 0;
+  }
+
+  auto memory_limit = result["memory_limit"].as<std::string>();
+  auto threads = result["threads"].as<std::string>();
+
+  duckdb::DuckDB db("tpch.duckdb");
+
+  if (result.count("load")) {
+    duckdb::Connection conn(db);
+
+    std::string sql = readfile("sql/init/duckdb.sql");
+    assert_success(conn.Query(sql));
+
+    for (const std::string &table : tpch_tables) {
+      assert_success(conn.Query("COPY " + table + " FROM '" + table +
+                                ".tbl' (DELIMITER '|')"));
+    }
+  }
+
+  if (result.count("run")) {
+    duckdb::Connection conn(db);
+
+    assert_success(conn.Query("PRAGMA memory_limit='" + memory_limit + "'"));
+    assert_success(conn.Query("PRAGMA threads=" + threads));
+
+    for (const std::string &table : tpch_tables) {
+      assert_success(conn.Query("SELECT * FROM " + table));
+    }
+
+    std::map<std::string, std::string> sql;
+    for (const std::string &query : tpch_queries) {
+      sql[query] = readfile("sql/" + query + ".sql");
+    }
+
+    for (const std::string &query : tpch_queries) {
+      std::cout << time([&] { assert_success(conn.Query(sql[query])); });
+      if (query != "q22") {
+        std::cout << "," << std::flush;
+      }
+    }
+    std::cout << std::endl;
+  }
+
+  return 0;
+}
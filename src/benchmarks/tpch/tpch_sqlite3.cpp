@@ -0,0 +1,86 @@
+#include "benchmarks/ssb/load.hpp"
+#include "cxxopts.hpp"
+#include "helpers.hpp"
+#include "readfile.hpp"
+#include "sqlite3.hpp"
+
+int main(int argc, char **argv) {
+  cxxopts::Options options = tpch_options("tpch_sqlite3", "TPC-H on SQLite3");
+
+  cxxopts::OptionAdder adder = options.add_options("SQLite3");
+  adder("bloom_filter", "Use Bloom filters",
+        cxxopts::value<bool>()->default_value("false"));
+  adder("cache_size", "Cache size",
+        cxxopts::value<std::string>()->default_value("-1000000"));
+  adder("load",
+        "Load the .tbl files into tpch.sqlite and print the time of each "
+        "table, instead of running the queries");
+  adder("threads", "Number of threads parsing the .tbl files with --load",
+        cxxopts::value<int>()->default_value("1"));
+
+  cxxopts::ParseResult result = options.parse(argc, argv);
+
+  if (result.count("help")) {
+    std::cout << options.help();
+    return 0;
+  }
+
+  int threads = result["threads"].as<int>();
+  if (threads < 1) {
+    throw std::runtime_error("--threads must be at least 1");
+  }
+
+  sqlite::Database db("tpch.sqlite");
+  sqlite::Connection conn;
+  db.connect(conn).expect(SQLITE_OK);
+  conn.execute("PRAGMA cache_size=" + result["cache_size"].as<std::string>())
+      .expect(SQLITE_OK);
+
+  // The foreign key indexes are built once the tables are loaded, and timed
+  // after the foreign key check.
+  if (result.count("load")) {
+    std::vector<double> times = load_tables(
+        conn.ptr().get(), load_statements(readfile("sql/init/sqlite3.sql")),
+        {tpch_tables.begin(), tpch_tables.end()}, threads, false);
+    std::string indexes = readfile("sql/init/sqlite3_indexes.sql");
+    times.push_back(time([&] { conn.execute(indexes).expect(SQLITE_OK); }));
+    for (size_t i = 0; i < times.size(); ++i) {
+      std::cout << (i > 0 ? "," : "") << times[i];
+    }
+    std::cout << std::endl;
+    return 0;
+  }
+
+  uint64_t mask = result["bloom_filter"].as<bool>() ? 0 : 0x00080000;
+  int rc = sqlite3_test_control(SQLITE_TESTCTRL_OPTIMIZATIONS, conn.ptr().get(),
+                                mask);
+  if (rc != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errmsg(conn.ptr().get()));
+  }
+
+  conn.execute("ANALYZE").expect(SQLITE_OK);
+  for (const std::string &table : tpch_tables) {
+    conn.execute("SELECT * FROM " + table).expect(SQLITE_OK);
+  }
+
+  // SQLite has no EXTRACT, so the queries that use it have a variant of
+  // their own.
+  std::map<std::string, std::string> sql;
+  for (const std::string &query : tpch_queries) {
+    std::string filename = "sql/" + query + ".sql";
+    if (std::ifstream("sql/sqlite3/" + query + ".sql").is_open()) {
+      filename = "sql/sqlite3/" + query + ".sql";
+    }
+    sql[query] = readfile(filename);
+  }
+
+  for (const std::string &query : tpch_queries) {
+    std::cout << time([&] { conn.execute(sql[query]).expect(SQLITE_OK); });
+    if (query != "q22") {
+      std::cout << "," << std::flush;
+    }
+  }
+  std::cout << std::endl;
+
+  return 0;
+}